@@ -1,17 +1,42 @@
 #include "6502cpu.h"
+#include "6502isa.h"
 #include "address.h"
 #include "byte_utils.h"
 #include "instruction_types.h"
 #include "psr.h"
+#include "throttle.h"
+
+#include <algorithm>
+#include <type_traits>
+
+static_assert(std::is_trivially_copyable_v<CPU6502>);
+
+const std::atomic<uint32_t> CPU6502::NO_INTERRUPTS{0};
+
+TraceHooks CPU6502::VERBOSE_TRACE;
 
 /**
- * Sets the ZERO (Z) and NEGATIVE (N) flags according to the value passed.
+ * Runs the reset sequence: registers are set to their power-on values and the
+ * program counter is loaded from the reset vector.
  *
- * @param value The value to update the flags with.
+ * Can be used to reuse one instance for several runs of a program.
+ *
+ * @return Whether the reset vector appears to be set.
  */
-void CPU6502::update_flags(std::byte value) {
-  P.set_bit(psr_bit::zero, value == ZERO_BYTE);
-  P.set_bit(psr_bit::negative, (value & MS_BIT_MASK) != ZERO_BYTE);
+bool CPU6502::reset() {
+  A = X = Y = ZERO_BYTE;
+  S = std::byte(STACK_START);
+  P = PSR();
+
+  // 1. read the reset vector from FFFC and FFFD
+  std::byte low = bus_->read(RESET_VECTOR_LOW);
+  std::byte high = bus_->read(RESET_VECTOR_HIGH);
+
+  // 2. set the program counter to the address in the reset vector
+  PC = address(low, high);
+
+  return !((low == FULL_BYTE && high == FULL_BYTE) ||
+           (low == ZERO_BYTE && high == ZERO_BYTE));
 }
 
 /**
@@ -22,7 +47,7 @@ void CPU6502::update_flags(std::byte value) {
  * @return Value popped from the stack.
  */
 std::byte CPU6502::pop_stack() {
-  std::byte value = memory_->read(address(S));
+  std::byte value = bus_->read(address(S));
 
   S = (S + 1).value;
 
@@ -39,215 +64,662 @@ std::byte CPU6502::pop_stack() {
 void CPU6502::push_stack(std::byte value) {
   S = (S - 1).value;
 
-  memory_->write(address(S), value);
+  bus_->write(address(S), value);
 }
 
 /**
- * @brief Executes the provided code in memory.
- *
- * The CPU will execute instructions until it reaches the end of the memory.
+ * Enters an interrupt handler: pushes the program counter and the status
+ * register, masks IRQs, leaves decimal mode and jumps to the handler.
  *
- * @return When the CPU reaches the end of the memory.
+ * @param vector The address of the handler address.
+ * @param brk Whether the B bit is set in the pushed status, which tells BRK
+ * from IRQ in the shared handler.
  */
-void CPU6502::execute() {
-  while (PC.inner() < memory_->size()) {
-    InstructionErr err = step();
+void CPU6502::interrupt(address vector, bool brk) {
+  push_stack(PC.high());
+  push_stack(PC.low());
 
-    if (err == InstructionErr::Stop) {
-      std::cout << std::endl << STP_MSG << std::endl;
+  PSR pushed = P;
+  pushed.set_bit(psr_bit::break_command, brk);
+  push_stack(pushed.get());
 
-      return;
-    }
-  }
+  P.set_bit(psr_bit::interrupt_disable, true);
+  P.set_bit(psr_bit::decimal_mode, false);
+
+  PC = address(bus_->read(vector), bus_->read((vector + 1).value));
 }
 
 /**
- * Makes one step of the CPU, equivallent to executing one @ref Instruction and
- * advances the program counter.
+ * Takes a pending interrupt, see @ref poll_interrupts. An NMI is always
+ * taken, an IRQ only while the I flag is clear.
  *
- * @return InstructionErr The result of the executed instruction.
+ * @return Whether an interrupt was taken.
  */
-InstructionErr CPU6502::step() {
-  std::byte opcode = memory_->read(PC);
+template <typename Policy> bool CPU6502::take_interrupt() {
+  uint32_t pending = pending_->load(std::memory_order_acquire);
+  address vector;
 
-  auto instruction = isa_.find(static_cast<size_t>(opcode));
+  if ((pending & STOP_PENDING) != 0) [[unlikely]] {
+    take_stop_request();
+  }
 
-  if (instruction == isa_.end()) {
-    std::cout << "Unknown opcode: " << std::hex << static_cast<int>(opcode)
-              << std::endl;
-    std::cout << "Exiting..." << std::endl;
+  if ((pending & NMI_PENDING) != 0 && interrupts_->take_nmi()) {
+    count_cycles(INTERRUPT_CYCLES);
+    vector = address(NMI_VECTOR);
+  } else if ((pending & IRQ_PENDING) != 0 &&
+             !P.get_bit(psr_bit::interrupt_disable)) {
+    count_cycles(INTERRUPT_CYCLES);
+    vector = address(IRQ_VECTOR);
+  } else {
+    return false;
+  }
 
-    return InstructionErr::UnknownInstruction;
+  if constexpr (Policy::hooks) {
+    hooks_->interrupt_entry(*this, vector);
   }
 
-  if (verbose_) {
-    std::cout << "INSTRUCTION: " << instruction->second.name << " ("
-              << instruction->first << ")" << std::endl
-              << "  PC: " << std::hex << static_cast<int>(PC.inner())
-              << std::endl;
+  interrupt(vector, false);
+
+  return true;
+}
+
+/**
+ * Takes a stop request of the host: the next @ref poll_events ends the run.
+ */
+void CPU6502::take_stop_request() {
+  if (!interrupts_->take_stop()) {
+    return;
   }
 
-  address op_address;
+  stop_requested_ = true;
 
-  switch (instruction->second.mode) {
-  case AddressingMode::Absolute: {
-    std::byte low = memory_->read((PC + 1).value);
-    std::byte high = memory_->read((PC + 2).value);
+  // count down to now, without skipping any cycles
+  event_cycle_ = get_cycles();
+  event_countdown_ = 0;
+}
 
-    op_address = address(low, high);
+/**
+ * Runs the scheduled events that are due, see @ref poll_events.
+ *
+ * @return Whether the CPU is still below the cycle limit and no stop was
+ * requested.
+ */
+bool CPU6502::run_events() {
+  if (scheduler_ != nullptr) {
+    scheduler_->run_due();
+  } else {
+    set_event_cycle(get_cycles() + EVENT_HORIZON);
+  }
 
-    break;
+  return get_cycles() < cycle_limit_ && !stop_requested_;
+}
+
+/**
+ * Sleeps until an interrupt is raised, for `WAI`. Returns right away while
+ * one is pending, even a masked IRQ; the CPU then goes on with the following
+ * instruction.
+ *
+ * While events are scheduled or the run has a cycle limit, the CPU skips
+ * ahead to the next event or the limit instead, it would only idle until
+ * then. Otherwise, the output of the program so far is written out before
+ * sleeping.
+ *
+ * @return Whether an interrupt was raised, false if the cycle limit was
+ * reached or a stop was requested first.
+ */
+bool CPU6502::wait_for_interrupt() {
+  uint32_t pending;
+
+  while ((pending = pending_->load(std::memory_order_acquire)) == 0) {
+    if (cycle_limit_ != NO_CYCLE_LIMIT ||
+        (scheduler_ != nullptr && scheduler_->has_events())) {
+      event_countdown_ = std::min<int64_t>(event_countdown_, 0);
+
+      if (!run_events()) {
+        return false;
+      }
+
+      continue;
+    }
+
+    bus_->stopped();
+
+    pending_->wait(0, std::memory_order_acquire);
   }
 
-  case AddressingMode::AbsoluteIndexedIndirect: {
-    std::byte low = memory_->read((PC + 1).value);
-    std::byte high = memory_->read((PC + 2).value);
+  if (pending == STOP_PENDING) {
+    take_stop_request();
 
-    address indirect_address = address(low, high);
+    return false;
+  }
 
-    std::byte low_indirect = memory_->read((indirect_address + X).value);
-    std::byte high_indirect =
-        memory_->read(((indirect_address + X).value + 1).value);
+  return true;
+}
 
-    op_address = address(low_indirect, high_indirect);
+/**
+ * @brief Executes the provided code in memory.
+ *
+ * The CPU will execute instructions until it reaches a STP instruction or an
+ * unknown opcode. Running past the end of the loaded image simply continues
+ * with the (zeroed) rest of the address space.
+ */
+void CPU6502::execute() {
+  InstructionErr err = run();
 
-    break;
+  if (err == InstructionErr::Stop) {
+    std::cout << '\n' << STP_MSG << '\n';
   }
+}
+
+/**
+ * Runs the program on the selected @ref ExecutionCore until an instruction
+ * returns something other than @ref InstructionErr::OK or
+ * @ref InstructionErr::OKPCModified.
+ *
+ * Interrupts and scheduled events are taken between instructions by the
+ * stepper and the threaded core, and between blocks by the cached and the JIT
+ * core.
+ *
+ * The run loop is the one of the @ref RunPolicy the hooks and the debug flag
+ * select. With hooks, including the trace of verbose mode, the program always
+ * runs on the stepper. Without debug mode, the run goes on after `DBG`.
+ * With a @ref Throttle, the program runs at its clock speed. Once the run
+ * stops, the devices are told so (see @ref Bus::stopped), which writes out
+ * buffered output.
+ *
+ * @throws CPUException If the selected core misses its cache or compiler.
+ * @return The result of the instruction that stopped the run.
+ */
+InstructionErr CPU6502::run() {
+  InstructionErr err =
+      throttle_ != nullptr ? throttle_->run(*this) : (this->*run_loop_)();
 
-  case AddressingMode::AbsoluteIndexedX: {
-    std::byte low = memory_->read((PC + 1).value);
-    std::byte high = memory_->read((PC + 2).value);
+  bus_->stopped();
 
-    op_address = (address(low, high) + X).value;
+  return err;
+}
 
-    break;
+/**
+ * Runs the program until an instruction stops it or the @p budget is used
+ * up, never throttled. Cycles are counted down with the scheduled events, so
+ * a cycle budget costs nothing per instruction, but the cached and the JIT
+ * core only stop between blocks and may go a few cycles over it. An
+ * instruction budget is counted by stepping, whatever the selected core.
+ *
+ * The cycle budget is checked once an instruction has run, so a run always
+ * executes at least one instruction: a budget of zero cycles runs exactly
+ * one, on every core.
+ *
+ * Once the run stops, the devices are told so (see @ref Bus::stopped).
+ *
+ * @throws CPUException If the selected core misses its cache or compiler.
+ */
+RunResult CPU6502::run(RunBudget budget) {
+  RunResult result;
+  uint64_t start = get_cycles();
+
+  set_cycle_limit(budget.cycles < NO_CYCLE_LIMIT - start ? start + budget.cycles
+                                                         : NO_CYCLE_LIMIT);
+
+  // the threaded and the block-based cores would stop before their first
+  // instruction, stepping runs it
+  if (budget.cycles == 0) {
+    budget.instructions = std::min<uint64_t>(budget.instructions, 1);
   }
 
-  case AddressingMode::AbsoluteIndexedY: {
-    std::byte low = memory_->read((PC + 1).value);
-    std::byte high = memory_->read((PC + 2).value);
+  InstructionErr err =
+      budget.instructions != UNLIMITED
+          ? (this->*steps_loop_)(budget.instructions, result.instructions)
+          : (this->*run_loop_)();
+
+  set_cycle_limit(NO_CYCLE_LIMIT);
+  bus_->stopped();
 
-    op_address = (address(low, high) + Y).value;
+  result.cycles = get_cycles() - start;
 
+  switch (err) {
+  case InstructionErr::Stop:
+    result.reason = StopReason::Stop;
+    break;
+  case InstructionErr::GoToDebugger:
+    result.reason = StopReason::Breakpoint;
+    break;
+  case InstructionErr::UnknownInstruction:
+    result.reason = StopReason::UnknownOpcode;
+    break;
+  case InstructionErr::StopRequested:
+    result.reason = StopReason::StopRequest;
+    break;
+  default:
+    result.reason = StopReason::Budget;
     break;
   }
 
-  case AddressingMode::AbsoluteIndirect: {
-    std::byte low = memory_->read((PC + 1).value);
-    std::byte high = memory_->read((PC + 2).value);
+  return result;
+}
 
-    size_t indirect_address =
-        (static_cast<size_t>(high) << 8) | static_cast<size_t>(low);
+/**
+ * Points the run loops at the instances of the @ref RunPolicy the hooks and
+ * the debug flag select.
+ */
+void CPU6502::select_policy() {
+  bool hooked = hooks_ != nullptr;
+
+  if (debug_ && hooked) {
+    run_loop_ = &CPU6502::run_unthrottled<HookedDebugging>;
+    steps_loop_ = &CPU6502::run_steps<HookedDebugging>;
+  } else if (debug_) {
+    run_loop_ = &CPU6502::run_unthrottled<Debugging>;
+    steps_loop_ = &CPU6502::run_steps<Debugging>;
+  } else if (hooked) {
+    run_loop_ = &CPU6502::run_unthrottled<Hooked>;
+    steps_loop_ = &CPU6502::run_steps<Hooked>;
+  } else {
+    run_loop_ = &CPU6502::run_unthrottled<Plain>;
+    steps_loop_ = &CPU6502::run_steps<Plain>;
+  }
+}
 
-    std::byte low_indirect = memory_->read(indirect_address);
-    std::byte high_indirect = memory_->read(indirect_address + 1);
+/**
+ * Decides whether a run goes on after @p err. `DBG` always leaves the core
+ * with @ref InstructionErr::GoToDebugger; without debug mode it is a NOP, so
+ * the run goes on, unless the cycle limit was reached meanwhile.
+ *
+ * @param err Set to @ref InstructionErr::CycleLimit if the limit was reached.
+ * @return Whether the run goes on.
+ */
+template <typename Policy>
+bool CPU6502::resume_after_break(InstructionErr &err) {
+  if constexpr (Policy::debug) {
+    return false;
+  } else {
+    if (err != InstructionErr::GoToDebugger) {
+      return false;
+    }
 
-    op_address = address(low_indirect, high_indirect);
+    if (!poll_events()) {
+      err = InstructionErr::CycleLimit;
 
-    break;
+      return false;
+    }
+
+    return true;
   }
+}
 
-  case AddressingMode::Accumulator: {
-    op_address = address(A);
+/**
+ * Runs the program as fast as possible, see @ref run.
+ *
+ * @return @ref InstructionErr::StopRequested instead of
+ * @ref InstructionErr::CycleLimit if the run ended on a stop request.
+ */
+template <typename Policy> InstructionErr CPU6502::run_unthrottled() {
+  InstructionErr err;
+
+  do {
+    if constexpr (Policy::hooks) {
+      err = run_stepper<Policy>();
+    } else {
+      err = run_core();
+    }
+  } while (resume_after_break<Policy>(err));
 
-    break;
+  if (stop_requested_) [[unlikely]] {
+    stop_requested_ = false;
+
+    if (err == InstructionErr::CycleLimit) {
+      return InstructionErr::StopRequested;
+    }
   }
 
-  case AddressingMode::Immediate: {
-    op_address = address((PC + 1).value);
+  return err;
+}
 
-    break;
+/**
+ * Runs the program like @ref run, but only until @p cycles more cycles have
+ * passed, and never throttled. The run stops at the first instruction
+ * boundary past the limit (block boundary on the cached and the JIT core), so
+ * it may overshoot by a few cycles; @ref get_cycles tells by how much.
+ *
+ * The limit costs nothing per instruction, it is counted down together with
+ * the scheduled events.
+ *
+ * @return @ref InstructionErr::CycleLimit if the limit was reached, otherwise
+ * the result of the instruction that stopped the run.
+ */
+InstructionErr CPU6502::run_for_cycles(uint64_t cycles) {
+  InstructionErr err = run_until(get_cycles() + cycles);
+
+  bus_->stopped();
+
+  return err;
+}
+
+/**
+ * Runs the program as fast as possible until the CPU reaches @p cycle, like
+ * @ref run_for_cycles, but without telling the devices it stopped. Meant for
+ * running a program in slices.
+ */
+InstructionErr CPU6502::run_until(uint64_t cycle) {
+  set_cycle_limit(cycle);
+
+  InstructionErr err = (this->*run_loop_)();
+
+  set_cycle_limit(NO_CYCLE_LIMIT);
+
+  return err;
+}
+
+/**
+ * Runs the program on the selected @ref ExecutionCore. See @ref run.
+ */
+InstructionErr CPU6502::run_core() {
+  switch (core_) {
+  case ExecutionCore::Threaded:
+    return run_threaded();
+  case ExecutionCore::Cached:
+    return run_cached();
+  case ExecutionCore::Jit:
+    return run_jit();
+  case ExecutionCore::Stepper:
+  default:
+    return run_stepper();
   }
+}
 
-  case AddressingMode::Implied: {
-    // used for instructions that manipulate PSR or instructions that have their
-    // operand implied
-    break;
+/**
+ * Runs the program by calling @ref step in a loop. See @ref run.
+ */
+template <typename Policy> InstructionErr CPU6502::run_stepper() {
+  while (true) {
+    address pc = PC;
+    InstructionErr err = step<Policy>();
+
+    if (err == InstructionErr::OKPCModified && PC == pc) [[unlikely]] {
+      skip_self_loop();
+    } else if (err != InstructionErr::OK &&
+               err != InstructionErr::OKPCModified) {
+      return err;
+    }
   }
+}
 
-  case AddressingMode::PCRelative: {
-    std::byte offset = memory_->read((PC + 1).value);
+/**
+ * Runs at most @p count instructions by calling @ref step in a loop.
+ *
+ * @param executed Set to the number of instructions executed.
+ * @return @ref InstructionErr::OK if all @p count instructions ran, otherwise
+ * the result of the instruction that stopped the run.
+ */
+template <typename Policy>
+InstructionErr CPU6502::run_steps(uint64_t count, uint64_t &executed) {
+  executed = 0;
 
-    int8_t signed_offset = static_cast<int8_t>(offset);
-    op_address = address(((PC + 2).value + signed_offset).value);
+  while (executed < count) {
+    InstructionErr err = step<Policy>();
 
-    break;
+    if (err != InstructionErr::UnknownInstruction) {
+      ++executed;
+    }
+
+    if (resume_after_break<Policy>(err)) {
+      continue;
+    }
+
+    if (stop_requested_) [[unlikely]] {
+      stop_requested_ = false;
+
+      if (err == InstructionErr::CycleLimit) {
+        return InstructionErr::StopRequested;
+      }
+    }
+
+    if (err != InstructionErr::OK && err != InstructionErr::OKPCModified) {
+      return err;
+    }
   }
 
-  case AddressingMode::Stack: {
-    op_address = address(static_cast<size_t>(S));
+  return InstructionErr::OK;
+}
 
-    break;
+/**
+ * Runs the program from the blocks of the @ref BlockCache. See @ref run.
+ *
+ * Instructions are taken from the decoded block instead of the memory, so
+ * after every instruction the block is left if it has overwritten any decoded
+ * code. Addresses where no block can be decoded are executed by @ref step.
+ *
+ * @throws CPUException If no cache was set.
+ */
+InstructionErr CPU6502::run_cached() {
+  if (block_cache_ == nullptr) {
+    throw CPUException("The cached core needs a block cache.");
   }
 
-  case AddressingMode::ZeroPage: {
-    std::byte low = memory_->read((PC + 1).value);
-    op_address = address(low);
+  while (true) {
+    if (!poll_events()) {
+      return InstructionErr::CycleLimit;
+    }
 
-    break;
+    poll_interrupts();
+
+    const DecodedBlock *block = block_cache_->lookup(PC);
+
+    InstructionErr err;
+
+    if (block == nullptr) {
+      err = step<Plain>();
+    } else if (block->idle_length != 0) [[unlikely]] {
+      err = run_idle_loop(*block);
+    } else {
+      err = run_block(*block);
+    }
+
+    if (err != InstructionErr::OK && err != InstructionErr::OKPCModified) {
+      return err;
+    }
   }
+}
+
+/**
+ * Interprets one decoded block, starting at its first instruction.
+ *
+ * @return @ref InstructionErr::OK if the block ran to its end or overwrote
+ * decoded code, @ref InstructionErr::OKPCModified if it left through a jump
+ * or a taken branch, otherwise the result of the instruction that stopped.
+ */
+InstructionErr CPU6502::run_block(const DecodedBlock &block) {
+  uint64_t code_version = bus_->code_version();
 
-  case AddressingMode::ZeroPageIndexedIndirect: {
-    std::byte low = memory_->read((PC + 1).value);
-    op_address = address((low + X).value);
+  for (const DecodedInstruction &instruction : block.fused) {
+    count_cycles(instruction.cycles);
 
-    std::byte low_indirect = memory_->read(op_address);
-    std::byte high_indirect = memory_->read((op_address + 1).value);
+    InstructionErr err = instruction.execute(*this, instruction);
 
-    op_address = address(low_indirect, high_indirect);
+    if (err != InstructionErr::OK) {
+      return err;
+    }
 
-    break;
+    if (bus_->code_version() != code_version) {
+      break;
+    }
   }
 
-  case AddressingMode::ZeroPageIndexedX: {
-    std::byte low = memory_->read((PC + 1).value);
-    op_address = address((low + X).value);
+  return InstructionErr::OK;
+}
 
-    break;
+/**
+ * Runs a block that starts with an idle loop candidate (see
+ * @ref DecodedBlock::idle_length). If one run of the loop ends where it
+ * started with the registers and flags unchanged, every following run does
+ * exactly the same, so the CPU skips ahead (see @ref skip_idle_loop).
+ *
+ * The loop is always interpreted, it is not worth compiling.
+ */
+InstructionErr CPU6502::run_idle_loop(const DecodedBlock &block) {
+  address start = PC;
+  std::byte a = A, x = X, y = Y, s = S, p = P.get();
+  uint64_t cycles = get_cycles();
+
+  InstructionErr err = run_block(block);
+
+  if (err == InstructionErr::OKPCModified && PC == start && A == a &&
+      X == x && Y == y && S == s && P.get() == p) {
+    skip_idle_loop(get_cycles() - cycles, block.idle_length);
   }
 
-  case AddressingMode::ZeroPageIndexedY: {
-    std::byte low = memory_->read((PC + 1).value);
-    op_address = address((low + Y).value);
+  return err;
+}
 
-    break;
+/**
+ * Skips ahead if the instruction at the program counter jumps or branches to
+ * itself, like `JMP *` or `BRA *`. Called by the stepper and the threaded
+ * core after an instruction left the program counter where it was.
+ *
+ * The instruction is not run again: from the same registers, it takes the
+ * same branch every time, as the zero page location BBRx/BBSx test does not
+ * change either (unless a device is mapped there). The cycles of a run are
+ * those of the branch to the program counter.
+ */
+void CPU6502::skip_self_loop() {
+  const Instruction &instruction =
+      isa[std::to_integer<size_t>(bus_->fetch(PC))];
+
+  if (!may_jump_to_itself(instruction) ||
+      (instruction.mode == AddressingMode::ZeroPageRelative &&
+       bus_->has_device(0))) {
+    return;
   }
 
-  case AddressingMode::ZeroPageIndirect: {
-    std::byte low = memory_->read((PC + 1).value);
+  uint64_t cycles = instruction.cycles;
 
-    std::byte low_indirect = memory_->read(address(low));
-    std::byte high_indirect = memory_->read((address(low) + 1).value);
+  if (instruction.mode == AddressingMode::ZeroPageRelative) {
+    cycles += ops::branch_cycles<AddressingMode::ZeroPageRelative>(*this, PC);
+  } else if (instruction.mnemonic == mnemonic_index("BRA")) {
+    cycles += ops::branch_cycles<AddressingMode::PCRelative, true>(*this, PC);
+  } else if (instruction.mode == AddressingMode::PCRelative) {
+    cycles += ops::branch_cycles<AddressingMode::PCRelative>(*this, PC);
+  }
 
-    op_address = address(low_indirect, high_indirect);
+  skip_idle_loop(cycles, 1);
+}
 
-    break;
+/**
+ * Skips ahead over an idle loop, which can only end once an event runs or an
+ * interrupt is raised. Whole runs of the loop are skipped up to the last one
+ * before the next event or the cycle limit, the rest is run as usual, so
+ * events happen at the same instruction as without skipping.
+ *
+ * Without events and a cycle limit, the CPU sleeps until an interrupt is
+ * raised instead, like `WAI`. Nothing is skipped while an interrupt is
+ * pending, even a masked one.
+ *
+ * @param cycles The cycles one run of the loop takes.
+ * @param instructions The instructions of one run of the loop.
+ */
+void CPU6502::skip_idle_loop(uint64_t cycles, uint64_t instructions) {
+  // an event (or a taken stop request) is due after this run anyway
+  if (event_countdown_ <= static_cast<int64_t>(cycles) ||
+      pending_->load(std::memory_order_acquire) != 0) {
+    return;
   }
 
-  case AddressingMode::ZeroPageIndirectIndexedY: {
-    std::byte low = memory_->read((PC + 1).value);
+  if (cycle_limit_ == NO_CYCLE_LIMIT &&
+      (scheduler_ == nullptr || !scheduler_->has_events())) {
+    ++idle_loops_;
 
-    std::byte low_indirect = memory_->read(address(low));
-    std::byte high_indirect = memory_->read((address(low) + 1).value);
+    bus_->stopped();
 
-    op_address = (address(low_indirect, high_indirect) + Y).value;
+    pending_->wait(0, std::memory_order_acquire);
 
-    break;
+    return;
   }
 
-  default:
-    // This should theoretically never happen. The assembler should produce the
-    // correct machine code.
-    throw CPUException("Addressing mode not implemented.");
+  uint64_t runs = (static_cast<uint64_t>(event_countdown_) - 1) / cycles;
+
+  event_countdown_ -= static_cast<int64_t>(runs * cycles);
+
+  ++idle_loops_;
+  skipped_instructions_ += runs * instructions;
+  skipped_cycles_ += runs * cycles;
+}
+
+void CPU6502::print_stats(std::ostream &stream) const {
+  stream << "Idle loops: skipped " << idle_loops_ << " times, "
+         << skipped_instructions_ << " instructions (" << skipped_cycles_
+         << " cycles) not run" << std::endl;
+}
+
+/**
+ * Reports an opcode without an instruction.
+ *
+ * @return Always @ref InstructionErr::UnknownInstruction.
+ */
+InstructionErr CPU6502::unknown_instruction(std::byte opcode) {
+  // the output of the program so far comes before the report
+  bus_->stopped();
+
+  std::cout << "Unknown opcode: " << std::hex << static_cast<int>(opcode)
+            << std::endl;
+  std::cout << "Exiting..." << std::endl;
+
+  return InstructionErr::UnknownInstruction;
+}
+
+/**
+ * Makes one step of the CPU, equivallent to executing one @ref Instruction.
+ * The instruction itself advances the program counter. A pending interrupt is
+ * taken first, the instruction is then the first one of its handler; the
+ * events due after the instruction are run last.
+ *
+ * Calls the hooks of the CPU, if it has any. `DBG` always returns
+ * @ref InstructionErr::GoToDebugger, debug mode or not.
+ *
+ * Returns @ref InstructionErr::CycleLimit instead of a successful result once
+ * the cycle limit is reached, see @ref run_for_cycles.
+ *
+ * @return InstructionErr The result of the executed instruction.
+ */
+InstructionErr CPU6502::step() {
+  return hooks_ != nullptr ? step<Hooked>() : step<Plain>();
+}
+
+/**
+ * Makes one step of the CPU like @ref step, instrumented as @p Policy says.
+ */
+template <typename Policy> InstructionErr CPU6502::step() {
+  poll_interrupts<Policy>();
+
+  std::byte opcode = bus_->fetch(PC);
+
+  const Instruction &instruction = isa[std::to_integer<size_t>(opcode)];
+
+  if (!instruction.valid()) {
+    return unknown_instruction(opcode);
+  }
+
+  if constexpr (Policy::hooks) {
+    hooks_->before_instruction(*this, opcode);
   }
 
-  InstructionErr ret_code = instruction->second.execute(*this, op_address);
+  count_cycles(instruction.cycles);
 
-  if (ret_code == InstructionErr::OKPCModified) {
-    return ret_code;
+  InstructionErr err =
+      instruction.execute(*this, fetch_operand(instruction.bytes));
+
+  if constexpr (Policy::hooks) {
+    hooks_->after_instruction(*this, opcode, err);
   }
 
-  PC = (PC + instruction->second.bytes).value;
+  if (!poll_events() &&
+      (err == InstructionErr::OK || err == InstructionErr::OKPCModified)) {
+    return InstructionErr::CycleLimit;
+  }
 
-  return ret_code;
+  return err;
 }
+
+// the other cores and the JIT run without instrumentation
+template bool CPU6502::take_interrupt<Plain>();
+template InstructionErr CPU6502::step<Plain>();
+template InstructionErr CPU6502::run_stepper<Plain>();
@@ -1,18 +1,37 @@
 #ifndef _H_6502CPU
 #define _H_6502CPU
 
-#include "6502isa.h"
 #include "address.h"
+#include "block_cache.h"
 #include "byte_utils.h"
-#include "gp_memory.h"
+#include "bus.h"
+#include "hooks.h"
 #include "instruction_types.h"
+#include "interrupt_controller.h"
 #include "psr.h"
+#include "scheduler.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
+#include <optional>
+#include <string_view>
 
-constexpr size_t MAX_MEMORY = 0x10000;
 constexpr unsigned short RESET_VECTOR_LOW = 0xFFFC;
 constexpr unsigned short RESET_VECTOR_HIGH = 0xFFFD;
+constexpr unsigned short NMI_VECTOR = 0xFFFA;
+/// Shared by IRQ and BRK.
+constexpr unsigned short IRQ_VECTOR = 0xFFFE;
+
+/// Cycles it takes to enter an IRQ or NMI handler.
+constexpr uint8_t INTERRUPT_CYCLES = 7;
+
+/// The cycle limit of a run without one, see @ref CPU6502::run_for_cycles.
+constexpr uint64_t NO_CYCLE_LIMIT = UINT64_MAX;
+
+/// A budget without a limit, see @ref RunBudget.
+constexpr uint64_t UNLIMITED = UINT64_MAX;
 
 constexpr size_t STACK_START = 0x1FF;
 
@@ -21,6 +40,98 @@ constexpr std::byte LS_BIT_MASK = std::byte(0x01);
 
 constexpr const char *STP_MSG = "== ENCOUNTERED STP, terminating... ==";
 
+/**
+ * The engines that can run a program. They produce identical register and
+ * memory state; they only differ in how instructions are dispatched.
+ */
+enum class ExecutionCore : uint8_t {
+  /// Call @ref CPU6502::step in a loop.
+  Stepper,
+  /// Jump directly from one handler to the next (see @ref
+  /// CPU6502::run_threaded).
+  Threaded,
+  /// Run predecoded blocks from a @ref BlockCache (see @ref
+  /// CPU6502::run_cached).
+  Cached,
+  /// Like @ref Cached, but compile hot blocks to host code (see @ref
+  /// CPU6502::run_jit).
+  Jit
+};
+
+/// Find the @ref ExecutionCore named @p name on the command line.
+inline std::optional<ExecutionCore>
+parse_execution_core(std::string_view name) {
+  if (name == "stepper") {
+    return ExecutionCore::Stepper;
+  } else if (name == "threaded") {
+    return ExecutionCore::Threaded;
+  } else if (name == "cached") {
+    return ExecutionCore::Cached;
+  } else if (name == "jit") {
+    return ExecutionCore::Jit;
+  }
+
+  return std::nullopt;
+}
+
+/// Why a run with a @ref RunBudget stopped, see @ref CPU6502::run.
+enum class StopReason : uint8_t {
+  /// The program executed `STP`.
+  Stop,
+  /// The program executed `DBG` in debug mode.
+  Breakpoint,
+  /// The program counter reached an opcode without an instruction.
+  UnknownOpcode,
+  /// The run used up its instructions or cycles.
+  Budget,
+  /// The host asked the CPU to stop (see @ref
+  /// InterruptController::request_stop).
+  StopRequest
+};
+
+/**
+ * How much a run may execute, see @ref CPU6502::run. A run executes at least
+ * one instruction, even with a budget of zero cycles.
+ */
+struct RunBudget {
+  uint64_t instructions = UNLIMITED;
+  uint64_t cycles = UNLIMITED;
+};
+
+/// The outcome of a run with a @ref RunBudget.
+struct RunResult {
+  StopReason reason = StopReason::Stop;
+  /// The instructions executed, only counted with an instruction budget.
+  uint64_t instructions = 0;
+  /// The cycles the run took.
+  uint64_t cycles = 0;
+};
+
+/**
+ * What the run loops of the CPU are instrumented with. Every policy gets a
+ * loop of its own (see @ref CPU6502::run), so the plain one has no
+ * instrumentation at all; the hooks and the debug flag of the CPU select the
+ * loop once, when they are set.
+ */
+template <bool Hooks, bool Debug> struct RunPolicy {
+  /// Call the @ref ExecutionHooks of the CPU, on the stepper.
+  static constexpr bool hooks = Hooks;
+  /// Stop at `DBG` and hand the CPU to the debugger; otherwise `DBG` is a NOP.
+  static constexpr bool debug = Debug;
+};
+
+/// No instrumentation, the production loop.
+using Plain = RunPolicy<false, false>;
+/// With hooks, e.g. in verbose mode.
+using Hooked = RunPolicy<true, false>;
+/// Debug mode.
+using Debugging = RunPolicy<false, true>;
+/// Debug mode with hooks.
+using HookedDebugging = RunPolicy<true, true>;
+
+class Jit;
+class Throttle;
+
 class CPUException {
 private:
   const char *message_;
@@ -31,59 +142,107 @@ public:
   const char *message() const { return message_; }
 };
 
-/// Class representing a W65C02S CPU.
+/**
+ * Class representing a W65C02S CPU.
+ *
+ * The instruction set is shared by all instances (see `isa`), so a CPU is
+ * only its registers and a pointer to the bus. Constructing one does not
+ * allocate.
+ */
 class CPU6502 {
+  // the compiled code accesses the registers directly
+  friend class Jit;
+
 private:
   // registers
   std::byte A, X, Y, S;
   PSR P;
   address PC;
 
-  // general purpose memory
-  GP_Memory *memory_;
-
-  CPU6502ISA isa_ = isa;
+  // the address space
+  Bus *bus_;
 
   bool debug_ = false;
-  bool verbose_ = false;
+  ExecutionHooks *hooks_ = nullptr;
+
+  /// The hooks of verbose mode.
+  static TraceHooks VERBOSE_TRACE;
+
+  // the loops of the policy the flags select, see select_policy
+  InstructionErr (CPU6502::*run_loop_)() = nullptr;
+  InstructionErr (CPU6502::*steps_loop_)(uint64_t, uint64_t &) = nullptr;
+
+  ExecutionCore core_ = ExecutionCore::Stepper;
+  BlockCache *block_cache_ = nullptr;
+  Jit *jit_ = nullptr;
+  Throttle *throttle_ = nullptr;
+
+  InterruptController *interrupts_ = nullptr;
+  /// The pending word of the controller, a word that stays zero without one.
+  const std::atomic<uint32_t> *pending_ = &NO_INTERRUPTS;
+
+  static const std::atomic<uint32_t> NO_INTERRUPTS;
+
+  Scheduler *scheduler_ = nullptr;
+  /// Cycles left until the next scheduled event, see @ref get_cycles.
+  int64_t event_countdown_ = static_cast<int64_t>(EVENT_HORIZON);
+  /// The cycle the countdown runs to, the next event or the cycle limit.
+  uint64_t event_cycle_ = EVENT_HORIZON;
+  /// The cycle of the next scheduled event.
+  uint64_t next_event_cycle_ = EVENT_HORIZON;
+  /// The cycle @ref run_for_cycles stops at.
+  uint64_t cycle_limit_ = NO_CYCLE_LIMIT;
+  /// Set once a stop request was taken, ends the run like the cycle limit.
+  bool stop_requested_ = false;
+
+  // idle loops skipped, see skip_idle_loop
+  uint64_t idle_loops_ = 0;
+  uint64_t skipped_instructions_ = 0;
+  uint64_t skipped_cycles_ = 0;
+
+  bool run_events();
+  template <typename Policy> bool take_interrupt();
+  void take_stop_request();
+  InstructionErr unknown_instruction(std::byte opcode);
+  void select_policy();
+  template <typename Policy> bool resume_after_break(InstructionErr &err);
+  InstructionErr run_core();
+  template <typename Policy> InstructionErr run_unthrottled();
+  template <typename Policy>
+  InstructionErr run_steps(uint64_t count, uint64_t &executed);
+  void skip_self_loop();
+  void skip_idle_loop(uint64_t cycles, uint64_t instructions);
+
+  /// Let @ref poll_events stop the run at @p cycle.
+  void set_cycle_limit(uint64_t cycle) {
+    cycle_limit_ = cycle;
+    set_event_cycle(next_event_cycle_);
+  }
 
 public:
   /**
-   * Create a new @ref CPU6502 instance with the provided @ref GP_Memory.
+   * Create a new @ref CPU6502 instance with the provided @ref Bus.
 
-   * @param memory The memory to use with the CPU.
+   * @param bus The bus to use with the CPU.
    * @param debug Whether to enable debug mode.
-   * @throws CPUException If the memory is null.
+   * @throws CPUException If the bus is null.
    */
-  CPU6502(GP_Memory *memory, bool debug = false)
-      : A(), X(), Y(), S(std::byte(STACK_START)), P(), PC(), memory_(memory),
+  CPU6502(Bus *bus, bool debug = false)
+      : A(), X(), Y(), S(std::byte(STACK_START)), P(), PC(), bus_(bus),
         debug_(debug) {
-    if (memory_ == nullptr) {
-      throw CPUException("Memory cannot be null.");
-    }
-
-    // a warning is perfectly fine here. the simulator is just
-    // going to ignore it because of the 16-bit address space.
-    if (memory_->size() > MAX_MEMORY) {
-      std::cout
-          << "Warning: Memory size is over the addressable limit of the CPU."
-          << std::endl;
+    if (bus_ == nullptr) {
+      throw CPUException("Bus cannot be null.");
     }
 
-    // reset sequence:
-    // 1. read the reset vector from FFFC and FFFD
-    std::byte low = memory_->read(RESET_VECTOR_LOW);
-    std::byte high = memory_->read(RESET_VECTOR_HIGH);
+    select_policy();
 
-    if ((low == FULL_BYTE && high == FULL_BYTE) ||
-        (low == ZERO_BYTE && high == ZERO_BYTE)) {
+    if (!reset()) {
       std::cout << "Warning: Reset vector appears not to be set." << std::endl;
     }
-
-    // 2. set the program counter to the address in the reset vector
-    PC = address(low, high);
   }
 
+  bool reset();
+
   std::byte get_A() const { return A; };
   void set_A(std::byte value) { A = value; };
   std::byte get_X() const { return X; };
@@ -100,22 +259,169 @@ public:
   PSR *get_PSR() { return &P; };
   PSR copy_PSR() { return P; };
 
-  const GP_Memory *get_memory() const { return memory_; };
-  GP_Memory *get_memory() { return memory_; };
+  const Bus *get_bus() const { return bus_; };
+  Bus *get_bus() { return bus_; };
 
-  void update_flags(std::byte value);
+  /**
+   * Sets the ZERO (Z) and NEGATIVE (N) flags according to the value passed.
+   *
+   * @param value The value to update the flags with.
+   */
+  void update_flags(std::byte value) { P.set_nz_from(value); }
 
   std::byte pop_stack();
   void push_stack(std::byte value);
 
+  /**
+   * Take a pending interrupt if it is not masked. Called between instructions,
+   * costs a load and a branch while no interrupt is pending.
+   */
+  template <typename Policy = Plain>
+  [[gnu::always_inline]] void poll_interrupts() {
+    if (pending_->load(std::memory_order_relaxed) != 0) [[unlikely]] {
+      take_interrupt<Policy>();
+    }
+  }
+
+  void interrupt(address vector, bool brk);
+  bool wait_for_interrupt();
+
+  /**
+   * Count the cycles of an instruction, before running it. The cores then
+   * call @ref poll_events between instructions.
+   */
+  [[gnu::always_inline]] void count_cycles(uint8_t cycles) {
+    event_countdown_ -= cycles;
+  }
+
+  /**
+   * Run the scheduled events that are due. Costs a comparison while none is.
+   *
+   * @return Whether the run goes on: the CPU is still below the cycle limit
+   * (see @ref run_for_cycles) and no stop was requested.
+   */
+  [[gnu::always_inline]] bool poll_events() {
+    if (event_countdown_ <= 0) [[unlikely]] {
+      return run_events();
+    }
+
+    return true;
+  }
+
+  /**
+   * The cycles run since the CPU was created. While an instruction runs, its
+   * own cycles are already counted.
+   */
+  uint64_t get_cycles() const {
+    return event_cycle_ - static_cast<uint64_t>(event_countdown_);
+  }
+
+  /**
+   * Run @ref poll_events when the CPU reaches @p cycle, or the cycle limit if
+   * that comes first.
+   */
+  void set_event_cycle(uint64_t cycle) {
+    uint64_t now = get_cycles();
+
+    next_event_cycle_ = cycle;
+    event_cycle_ = std::min(cycle, cycle_limit_);
+    event_countdown_ = static_cast<int64_t>(event_cycle_ - now);
+  }
+
+  /**
+   * Read the raw operand of the instruction at the program counter.
+   *
+   * @param bytes The length of the instruction, including the opcode.
+   */
+  [[gnu::always_inline]] address fetch_operand(uint8_t bytes) const {
+    if (bytes == 2) {
+      return address(bus_->fetch((PC + 1).value));
+    } else if (bytes == 3) {
+      return address(bus_->fetch((PC + 1).value),
+                     bus_->fetch((PC + 2).value));
+    }
+
+    return address();
+  }
+
   void execute();
   InstructionErr step();
+  template <typename Policy> InstructionErr step();
+
+  InstructionErr run();
+  RunResult run(RunBudget budget);
+  InstructionErr run_for_cycles(uint64_t cycles);
+  InstructionErr run_until(uint64_t cycle);
+  template <typename Policy = Plain> InstructionErr run_stepper();
+  InstructionErr run_threaded();
+  InstructionErr run_cached();
+  InstructionErr run_jit();
+  InstructionErr run_block(const DecodedBlock &block);
+  InstructionErr run_idle_loop(const DecodedBlock &block);
+
+  /// Instructions of idle loops that were skipped instead of run.
+  uint64_t skipped_instructions() const { return skipped_instructions_; };
+  /// Have any idle loops been skipped?
+  bool skipped_idle_loops() const { return idle_loops_ != 0; };
 
-  void set_debug(bool value) { debug_ = value; };
+  void print_stats(std::ostream &stream) const;
+
+  void set_debug(bool value) {
+    debug_ = value;
+    select_policy();
+  };
   bool is_debug() { return debug_; };
 
-  void set_verbose(bool value) { verbose_ = value; };
-  bool is_verbose() { return verbose_; };
+  /**
+   * Call @p hooks while running, or run without hooks again if it is null
+   * (see @ref ExecutionHooks). Not owned by the CPU. Replaces the trace of
+   * verbose mode.
+   */
+  void set_hooks(ExecutionHooks *hooks) {
+    hooks_ = hooks;
+    bus_->set_hooks(hooks);
+    select_policy();
+  };
+  ExecutionHooks *get_hooks() { return hooks_; };
+
+  /// Print every instruction and interrupt, with @ref TraceHooks.
+  void set_verbose(bool value) {
+    if (value) {
+      set_hooks(&VERBOSE_TRACE);
+    } else if (is_verbose()) {
+      set_hooks(nullptr);
+    }
+  };
+  bool is_verbose() { return hooks_ == &VERBOSE_TRACE; };
+
+  void set_core(ExecutionCore value) { core_ = value; };
+  ExecutionCore get_core() const { return core_; };
+
+  /// The cache used by @ref ExecutionCore::Cached, not owned by the CPU.
+  void set_block_cache(BlockCache *cache) { block_cache_ = cache; };
+
+  /// The compiler used by @ref ExecutionCore::Jit, not owned by the CPU.
+  void set_jit(Jit *jit) { jit_ = jit; };
+
+  /**
+   * Run at the clock speed of @p throttle instead of as fast as possible, or
+   * unthrottled again if it is null. Not owned by the CPU.
+   */
+  void set_throttle(Throttle *throttle) { throttle_ = throttle; };
+
+  /**
+   * The IRQ and NMI lines, not owned by the CPU. Without a controller, no
+   * interrupt is ever raised.
+   */
+  void set_interrupts(InterruptController *interrupts) {
+    interrupts_ = interrupts;
+    pending_ = interrupts != nullptr ? &interrupts->pending() : &NO_INTERRUPTS;
+  };
+  InterruptController *get_interrupts() { return interrupts_; };
+
+  /// The events of devices, not owned by the CPU (see @ref Scheduler).
+  void set_scheduler(Scheduler *scheduler) { scheduler_ = scheduler; };
+  Scheduler *get_scheduler() { return scheduler_; };
 };
 
 #endif
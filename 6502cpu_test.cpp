@@ -0,0 +1,382 @@
+#include "6502cpu.h"
+#include "6502isa.h"
+#include "address.h"
+#include "instruction_types.h"
+#include "interrupt_controller.h"
+#include "scheduler.h"
+#include "unit_test.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <initializer_list>
+
+constexpr uint8_t STP = 0xDB;
+
+constexpr ExecutionCore CORES[] = {ExecutionCore::Stepper,
+                                   ExecutionCore::Threaded,
+                                   ExecutionCore::Cached, ExecutionCore::Jit};
+
+static const char *core_name(ExecutionCore core) {
+  switch (core) {
+  case ExecutionCore::Threaded:
+    return "threaded";
+  case ExecutionCore::Cached:
+    return "cached";
+  case ExecutionCore::Jit:
+    return "jit";
+  case ExecutionCore::Stepper:
+  default:
+    return "stepper";
+  }
+}
+
+/// The cycles the instruction at @p pc takes above its base cycles.
+static uint64_t extra_cycles(TestMachine &machine, uint16_t pc) {
+  machine.cpu.set_PC(address(pc));
+
+  uint64_t start = machine.cpu.get_cycles();
+  machine.cpu.step();
+
+  const Instruction &instruction =
+      isa[std::to_integer<size_t>(machine.bus.read(address(pc)))];
+
+  return machine.cpu.get_cycles() - start - instruction.cycles;
+}
+
+/**
+ * Indexed reads and the shifts and rotations on abs,X take a cycle more when
+ * the indexing crosses a page; stores do not.
+ */
+static void check_page_crossing() {
+  struct Case {
+    std::initializer_list<uint8_t> bytes;
+    uint8_t index;
+    uint64_t extra;
+  };
+
+  // the base address is 30FF, the pointer at 10 points to it
+  const Case cases[] = {
+      {{0xBD, 0xFF, 0x30}, 0, 0}, {{0xBD, 0xFF, 0x30}, 1, 1},
+      {{0xB9, 0xFF, 0x30}, 0, 0}, {{0xB9, 0xFF, 0x30}, 1, 1},
+      {{0xB1, 0x10}, 0, 0},       {{0xB1, 0x10}, 1, 1},
+      {{0x1E, 0xFF, 0x30}, 0, 0}, {{0x1E, 0xFF, 0x30}, 1, 1},
+      {{0x7E, 0xFF, 0x30}, 1, 1}, {{0x9D, 0xFF, 0x30}, 1, 0},
+      {{0x99, 0xFF, 0x30}, 1, 0}, {{0x91, 0x10}, 1, 0}};
+
+  for (const Case &c : cases) {
+    TestMachine machine;
+    machine.load(0x0010, {0xFF, 0x30});
+    machine.load(TEST_CODE, c.bytes);
+    machine.cpu.set_X(std::byte(c.index));
+    machine.cpu.set_Y(std::byte(c.index));
+
+    uint64_t extra = extra_cycles(machine, TEST_CODE);
+
+    check(extra == c.extra,
+          std::format("{} ({}) indexed by {} takes {} extra cycles, "
+                      "expected {}",
+                      isa[*c.bytes.begin()].name(),
+                      static_cast<int>(*c.bytes.begin()),
+                      static_cast<int>(c.index), extra, c.extra));
+  }
+}
+
+/**
+ * A taken branch takes a cycle more, and another one when it lands on a
+ * different page than the following instruction. BRA is always taken, its
+ * base cycles include that.
+ */
+static void check_branch_cycles() {
+  struct Case {
+    const char *what;
+    std::initializer_list<uint8_t> bytes;
+    uint64_t extra;
+  };
+
+  // Z is clear, the branch is at 0200 and the next instruction at 0202
+  const Case cases[] = {{"BEQ not taken", {0xF0, 0x10}, 0},
+                        {"BNE to 0212", {0xD0, 0x10}, 1},
+                        {"BNE to 01F2", {0xD0, 0xF0}, 2},
+                        {"BRA to 0212", {0x80, 0x10}, 0},
+                        {"BRA to 01F2", {0x80, 0xF0}, 1}};
+
+  for (const Case &c : cases) {
+    TestMachine machine;
+    machine.load(TEST_CODE, c.bytes);
+    machine.cpu.set_PSR(PSR(std::byte{0x00}));
+
+    uint64_t extra = extra_cycles(machine, TEST_CODE);
+
+    check(extra == c.extra,
+          std::format("{} takes {} extra cycles, expected {}", c.what, extra,
+                      c.extra));
+  }
+}
+
+/**
+ * Every core counts the same cycles for a loop, also once the JIT has
+ * compiled it, with the taken branch back on the same page and on the page
+ * before.
+ */
+static void check_loop_cycles() {
+  struct Case {
+    uint16_t start;
+    /// The cycles of a taken BNE.
+    uint64_t taken;
+  };
+
+  constexpr Case CASES[] = {{0x0200, 3}, {0x02FC, 4}};
+
+  for (ExecutionCore core : CORES) {
+    for (const Case &c : CASES) {
+      CoreMachine machine(core);
+      // LDX #0; loop: DEX; BNE loop; STP
+      machine.load(c.start, {0xA2, 0x00, 0xCA, 0xD0, 0xFD, STP});
+      machine.cpu.set_PC(address(c.start));
+
+      InstructionErr err = machine.cpu.run();
+
+      uint64_t expected = 2 + 256 * 2 + 255 * c.taken + 2 + isa[STP].cycles;
+
+      check(err == InstructionErr::Stop &&
+                machine.cpu.get_cycles() == expected,
+            std::format("{}: the loop at {} takes {} cycles, expected {}",
+                        core_name(core), c.start,
+                        machine.cpu.get_cycles(), expected));
+    }
+  }
+}
+
+/**
+ * run_for_cycles stops at the first instruction past the limit on the
+ * stepper and the threaded core, and at the end of the first block past it
+ * on the cached and the JIT core. A page of NOPs is one block of 512 cycles.
+ */
+static void check_run_for_cycles() {
+  struct Run {
+    uint64_t cycles;
+    /// Where the stepper and the threaded core stop.
+    uint64_t instruction_end;
+    /// Where the cached and the JIT core stop.
+    uint64_t block_end;
+  };
+
+  constexpr Run RUNS[] = {{100, 100, 512}, {11, 112, 1024}, {300, 412, 1536}};
+
+  for (ExecutionCore core : CORES) {
+    CoreMachine machine(core);
+    machine.fill(NOP);
+
+    bool blocks =
+        core == ExecutionCore::Cached || core == ExecutionCore::Jit;
+
+    for (const Run &run : RUNS) {
+      InstructionErr err = machine.cpu.run_for_cycles(run.cycles);
+
+      uint64_t expected = blocks ? run.block_end : run.instruction_end;
+      address pc(static_cast<uint16_t>(TEST_CODE + expected / 2));
+
+      if (!check(err == InstructionErr::CycleLimit &&
+                     machine.cpu.get_cycles() == expected &&
+                     machine.cpu.get_PC() == pc,
+                 std::format("{}: run_for_cycles({}) stopped at {}, "
+                             "expected {}",
+                             core_name(core), run.cycles,
+                             machine.cpu.get_cycles(), expected))) {
+        break;
+      }
+    }
+  }
+}
+
+static const char *reason_name(StopReason reason) {
+  switch (reason) {
+  case StopReason::Stop:
+    return "stop";
+  case StopReason::Breakpoint:
+    return "breakpoint";
+  case StopReason::UnknownOpcode:
+    return "unknown opcode";
+  case StopReason::Budget:
+    return "budget";
+  case StopReason::StopRequest:
+  default:
+    return "stop request";
+  }
+}
+
+/// The first opcode without an instruction.
+static uint8_t unknown_opcode() {
+  uint8_t opcode = 0;
+
+  while (isa[opcode].valid()) {
+    ++opcode;
+  }
+
+  return opcode;
+}
+
+/**
+ * A run with a budget reports why it stopped: STP, DBG in debug mode, an
+ * unknown opcode or a stop request of the host, after a few NOPs.
+ */
+static void check_stop_reasons() {
+  struct Case {
+    StopReason reason;
+    uint8_t opcode;
+  };
+
+  const Case cases[] = {{StopReason::Stop, STP},
+                        {StopReason::Breakpoint, 0x02},
+                        {StopReason::UnknownOpcode, unknown_opcode()},
+                        {StopReason::StopRequest, NOP}};
+
+  for (ExecutionCore core : CORES) {
+    for (const Case &c : cases) {
+      CoreMachine machine(core);
+      InterruptController interrupts;
+      machine.cpu.set_interrupts(&interrupts);
+      machine.cpu.set_debug(true);
+      machine.fill(NOP);
+      machine.load(TEST_CODE + 4, {c.opcode});
+
+      if (c.reason == StopReason::StopRequest) {
+        interrupts.request_stop();
+      }
+
+      RunResult result = machine.cpu.run(RunBudget{});
+
+      check(result.reason == c.reason,
+            std::format("{}: the run stopped for {}, expected {}",
+                        core_name(core), reason_name(result.reason),
+                        reason_name(c.reason)));
+    }
+  }
+}
+
+/**
+ * An instruction budget runs exactly that many instructions on every core, a
+ * cycle budget stops like @ref CPU6502::run_for_cycles, and with both the
+ * first one used up stops the run. A budget of zero cycles runs one
+ * instruction.
+ */
+static void check_budgets() {
+  struct Case {
+    const char *what;
+    RunBudget budget;
+    uint64_t instructions;
+    /// The cycles on the stepper and the threaded core.
+    uint64_t cycles;
+    /// The cycles on the cached and the JIT core.
+    uint64_t block_cycles;
+  };
+
+  constexpr Case CASES[] = {
+      {"10 instructions", {10, UNLIMITED}, 10, 20, 20},
+      {"20 cycles", {UNLIMITED, 20}, 0, 20, 512},
+      {"10 instructions or 7 cycles", {10, 7}, 4, 8, 8},
+      {"10 instructions or 100 cycles", {10, 100}, 10, 20, 20},
+      {"0 cycles", {UNLIMITED, 0}, 1, 2, 2},
+      {"0 instructions", {0, UNLIMITED}, 0, 0, 0}};
+
+  for (ExecutionCore core : CORES) {
+    for (const Case &c : CASES) {
+      CoreMachine machine(core);
+      machine.fill(NOP);
+
+      RunResult result = machine.cpu.run(c.budget);
+
+      bool blocks =
+          core == ExecutionCore::Cached || core == ExecutionCore::Jit;
+      uint64_t cycles = blocks ? c.block_cycles : c.cycles;
+
+      check(result.reason == StopReason::Budget &&
+                result.instructions == c.instructions &&
+                result.cycles == cycles &&
+                machine.cpu.get_cycles() == cycles,
+            std::format("{}: {} ran {} instructions in {} cycles, "
+                        "expected {} in {}",
+                        core_name(core), c.what, result.instructions,
+                        result.cycles, c.instructions, cycles));
+    }
+  }
+}
+
+/**
+ * A jump or branch to itself is skipped by every core: all passes but the
+ * first and the last one, which runs into the cycle limit.
+ */
+static void check_self_loop_skipping() {
+  for (ExecutionCore core : CORES) {
+    CoreMachine machine(core);
+    // BRA *, 3 cycles a pass
+    machine.load(TEST_CODE, {0x80, 0xFE});
+
+    machine.cpu.run_for_cycles(3000);
+
+    check(machine.cpu.get_cycles() == 3000 &&
+              machine.cpu.skipped_instructions() == 998,
+          std::format("{}: BRA * for 3000 cycles skipped {} instructions "
+                      "and stopped at {}, expected 998 and 3000",
+                      core_name(core), machine.cpu.skipped_instructions(),
+                      machine.cpu.get_cycles()));
+  }
+}
+
+/**
+ * An event ends a loop polling a RAM location on the same instruction and
+ * cycle whether or not the loop is skipped: the cached and the JIT core skip
+ * it, the stepper and the threaded core run every pass.
+ */
+static void check_poll_loop_skipping() {
+  for (ExecutionCore core : CORES) {
+    CoreMachine machine(core);
+    Scheduler scheduler(&machine.cpu);
+    machine.cpu.set_scheduler(&scheduler);
+
+    // wait: LDA $10; BEQ wait; STP, 6 cycles a pass
+    machine.load(TEST_CODE, {0xA5, 0x10, 0xF0, 0xFC, STP});
+
+    uint64_t event_cycle = 0;
+    address event_pc;
+
+    scheduler.schedule(1000, [&](uint64_t) {
+      event_cycle = machine.cpu.get_cycles();
+      event_pc = machine.cpu.get_PC();
+      machine.bus.write(address(0x0010), std::byte{0x01});
+    });
+
+    InstructionErr err = machine.cpu.run();
+
+    bool blocks =
+        core == ExecutionCore::Cached || core == ExecutionCore::Jit;
+    // the first pass sets Z, the loop is found on the second one
+    uint64_t skipped = blocks ? 328 : 0;
+
+    check(err == InstructionErr::Stop && event_cycle == 1002 &&
+              event_pc == address(TEST_CODE) &&
+              machine.cpu.get_cycles() == 1010 &&
+              machine.cpu.skipped_instructions() == skipped,
+          std::format("{}: the event ran at cycle {} on {}, the loop ended "
+                      "at {} and {} instructions were skipped, expected "
+                      "1002 on {}, 1010 and {}",
+                      core_name(core), event_cycle, event_pc.inner(),
+                      machine.cpu.get_cycles(),
+                      machine.cpu.skipped_instructions(), TEST_CODE,
+                      skipped));
+  }
+}
+
+int main() {
+  check_page_crossing();
+  check_branch_cycles();
+  check_loop_cycles();
+  check_run_for_cycles();
+  check_stop_reasons();
+  check_budgets();
+  check_self_loop_skipping();
+  check_poll_loop_skipping();
+
+  return finish_checks("6502cpu");
+}
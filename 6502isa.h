@@ -1,11 +1,357 @@
 #ifndef _H_6502ISA
 #define _H_6502ISA
 
+#include "6502cpu.h"
+#include "6502ops.h"
 #include "instruction_types.h"
-#include <unordered_map>
+#include "psr.h"
 
-using CPU6502ISA = std::unordered_map<size_t, Instruction>;
+#include <array>
+#include <cstdint>
+#include <initializer_list>
 
-extern CPU6502ISA isa;
+/**
+ * The instruction set, indexed directly by opcode. Shared by all CPUs and
+ * initialized at compile time.
+ */
+using CPU6502ISA = std::array<Instruction, 256>;
+
+namespace isa_detail {
+using namespace ops;
+
+template <AddressingMode Mode, typename Op>
+constexpr Instruction read_op(uint8_t cycles) {
+  return Instruction(Op::NAME, Mode, cycles, read<Mode, Op>);
+}
+
+template <AddressingMode Mode, typename Op>
+constexpr Instruction write_op(uint8_t cycles) {
+  return Instruction(Op::NAME, Mode, cycles, write<Mode, Op>);
+}
+
+template <AddressingMode Mode, typename Op>
+constexpr Instruction modify_op(uint8_t cycles) {
+  return Instruction(Op::NAME, Mode, cycles, modify<Mode, Op>);
+}
+
+template <AddressingMode Mode, typename Op>
+constexpr Instruction implied_op(uint8_t cycles) {
+  return Instruction(Op::NAME, Mode, cycles, implied<Mode, Op>);
+}
+
+struct ISAEntry {
+  uint8_t opcode;
+  Instruction instruction;
+};
+
+/**
+ * Lay out the instructions in a table indexed directly by their opcode.
+ *
+ * Opcodes that are not listed stay invalid (see @ref Instruction::valid).
+ * Listing one opcode twice is rejected at compile time.
+ */
+constexpr CPU6502ISA make_isa(std::initializer_list<ISAEntry> entries) {
+  CPU6502ISA table{};
+
+  for (const ISAEntry &entry : entries) {
+    if (table[entry.opcode].valid()) {
+      throw CPUException("Duplicate opcode in the instruction set.");
+    }
+
+    table[entry.opcode] = entry.instruction;
+  }
+
+  return table;
+}
+
+/// The instruction set, sorted by opcode.
+constexpr CPU6502ISA build_isa() {
+  return make_isa({
+      {0x00, Instruction("BRK", Stack, 7, break_interrupt)},
+      {0x01, read_op<ZeroPageIndexedIndirect, ORA>(6)},
+      {0x02, Instruction("DBG", Implied, 2, debug_break)},
+      {0x04, modify_op<ZeroPage, TSB>(5)},
+      {0x05, read_op<ZeroPage, ORA>(3)},
+      {0x06, modify_op<ZeroPage, ASL>(5)},
+      {0x07, modify_op<ZeroPage, RMB<0>>(5)},
+      {0x08, implied_op<Stack, PHP>(3)},
+      {0x09, read_op<Immediate, ORA>(2)},
+      {0x0A, modify_op<Accumulator, ASL>(2)},
+      {0x0C, modify_op<Absolute, TSB>(6)},
+      {0x0D, read_op<Absolute, ORA>(4)},
+      {0x0E, modify_op<Absolute, ASL>(6)},
+      {0x0F, Instruction("BBR0", ZeroPageRelative, 5, branch_on_bit<0, false>)},
+      {0x10,
+       Instruction("BPL", PCRelative, 2, branch<psr_bit::negative, false>)},
+      {0x11, read_op<ZeroPageIndirectIndexedY, ORA>(5)},
+      {0x12, read_op<ZeroPageIndirect, ORA>(5)},
+      {0x14, modify_op<ZeroPage, TRB>(5)},
+      {0x15, read_op<ZeroPageIndexedX, ORA>(4)},
+      {0x16, modify_op<ZeroPageIndexedX, ASL>(6)},
+      {0x17, modify_op<ZeroPage, RMB<1>>(5)},
+      {0x18, implied_op<Implied, CLC>(2)},
+      {0x19, read_op<AbsoluteIndexedY, ORA>(4)},
+      {0x1A, modify_op<Accumulator, INC>(2)},
+      {0x1C, modify_op<Absolute, TRB>(6)},
+      {0x1D, read_op<AbsoluteIndexedX, ORA>(4)},
+      {0x1E, modify_op<AbsoluteIndexedX, ASL>(6)},
+      {0x1F, Instruction("BBR1", ZeroPageRelative, 5, branch_on_bit<1, false>)},
+      {0x20, Instruction("JSR", Absolute, 6, jump_subroutine)},
+      {0x21, read_op<ZeroPageIndexedIndirect, AND>(6)},
+      {0x24, read_op<ZeroPage, BIT>(3)},
+      {0x25, read_op<ZeroPage, AND>(3)},
+      {0x26, modify_op<ZeroPage, ROL>(5)},
+      {0x27, modify_op<ZeroPage, RMB<2>>(5)},
+      {0x28, implied_op<Stack, PLP>(4)},
+      {0x29, read_op<Immediate, AND>(2)},
+      {0x2A, modify_op<Accumulator, ROL>(2)},
+      {0x2C, read_op<Absolute, BIT>(4)},
+      {0x2D, read_op<Absolute, AND>(4)},
+      {0x2E, modify_op<Absolute, ROL>(6)},
+      {0x2F, Instruction("BBR2", ZeroPageRelative, 5, branch_on_bit<2, false>)},
+      {0x30,
+       Instruction("BMI", PCRelative, 2, branch<psr_bit::negative, true>)},
+      {0x31, read_op<ZeroPageIndirectIndexedY, AND>(5)},
+      {0x32, read_op<ZeroPageIndirect, AND>(5)},
+      {0x34, read_op<ZeroPageIndexedX, BIT>(4)},
+      {0x35, read_op<ZeroPageIndexedX, AND>(4)},
+      {0x36, modify_op<ZeroPageIndexedX, ROL>(6)},
+      {0x37, modify_op<ZeroPage, RMB<3>>(5)},
+      {0x38, implied_op<Implied, SEC>(2)},
+      {0x39, read_op<AbsoluteIndexedY, AND>(4)},
+      {0x3A, modify_op<Accumulator, DEC>(2)},
+      {0x3C, read_op<AbsoluteIndexedX, BIT>(4)},
+      {0x3D, read_op<AbsoluteIndexedX, AND>(4)},
+      {0x3E, modify_op<AbsoluteIndexedX, ROL>(6)},
+      {0x3F, Instruction("BBR3", ZeroPageRelative, 5, branch_on_bit<3, false>)},
+      {0x40, Instruction("RTI", Stack, 6, return_interrupt)},
+      {0x41, read_op<ZeroPageIndexedIndirect, EOR>(6)},
+      {0x45, read_op<ZeroPage, EOR>(3)},
+      {0x46, modify_op<ZeroPage, LSR>(5)},
+      {0x47, modify_op<ZeroPage, RMB<4>>(5)},
+      {0x48, implied_op<Stack, PHA>(3)},
+      {0x49, read_op<Immediate, EOR>(2)},
+      {0x4A, modify_op<Accumulator, LSR>(2)},
+      {0x4C, Instruction("JMP", Absolute, 3, jump<Absolute>)},
+      {0x4D, read_op<Absolute, EOR>(4)},
+      {0x4E, modify_op<Absolute, LSR>(6)},
+      {0x4F, Instruction("BBR4", ZeroPageRelative, 5, branch_on_bit<4, false>)},
+      {0x50,
+       Instruction("BVC", PCRelative, 2, branch<psr_bit::overflow, false>)},
+      {0x51, read_op<ZeroPageIndirectIndexedY, EOR>(5)},
+      {0x52, read_op<ZeroPageIndirect, EOR>(5)},
+      {0x55, read_op<ZeroPageIndexedX, EOR>(4)},
+      {0x56, modify_op<ZeroPageIndexedX, LSR>(6)},
+      {0x57, modify_op<ZeroPage, RMB<5>>(5)},
+      {0x58, implied_op<Implied, CLI>(2)},
+      {0x59, read_op<AbsoluteIndexedY, EOR>(4)},
+      {0x5A, implied_op<Stack, PHY>(3)},
+      {0x5D, read_op<AbsoluteIndexedX, EOR>(4)},
+      {0x5E, modify_op<AbsoluteIndexedX, LSR>(6)},
+      {0x5F, Instruction("BBR5", ZeroPageRelative, 5, branch_on_bit<5, false>)},
+      {0x60, Instruction("RTS", Stack, 6, return_subroutine)},
+      {0x61, read_op<ZeroPageIndexedIndirect, ADC>(6)},
+      {0x64, write_op<ZeroPage, STZ>(3)},
+      {0x65, read_op<ZeroPage, ADC>(3)},
+      {0x66, modify_op<ZeroPage, ROR>(5)},
+      {0x67, modify_op<ZeroPage, RMB<6>>(5)},
+      {0x68, implied_op<Stack, PLA>(4)},
+      {0x69, read_op<Immediate, ADC>(2)},
+      {0x6A, modify_op<Accumulator, ROR>(2)},
+      {0x6C, Instruction("JMP", AbsoluteIndirect, 6, jump<AbsoluteIndirect>)},
+      {0x6D, read_op<Absolute, ADC>(4)},
+      {0x6E, modify_op<Absolute, ROR>(6)},
+      {0x6F, Instruction("BBR6", ZeroPageRelative, 5, branch_on_bit<6, false>)},
+      {0x70,
+       Instruction("BVS", PCRelative, 2, branch<psr_bit::overflow, true>)},
+      {0x71, read_op<ZeroPageIndirectIndexedY, ADC>(5)},
+      {0x72, read_op<ZeroPageIndirect, ADC>(5)},
+      {0x74, write_op<ZeroPageIndexedX, STZ>(4)},
+      {0x75, read_op<ZeroPageIndexedX, ADC>(4)},
+      {0x76, modify_op<ZeroPageIndexedX, ROR>(6)},
+      {0x77, modify_op<ZeroPage, RMB<7>>(5)},
+      {0x78, implied_op<Implied, SEI>(2)},
+      {0x79, read_op<AbsoluteIndexedY, ADC>(4)},
+      {0x7A, implied_op<Stack, PLY>(4)},
+      {0x7C, Instruction("JMP", AbsoluteIndexedIndirect, 6,
+                         jump<AbsoluteIndexedIndirect>)},
+      {0x7D, read_op<AbsoluteIndexedX, ADC>(4)},
+      {0x7E, modify_op<AbsoluteIndexedX, ROR>(6)},
+      {0x7F, Instruction("BBR7", ZeroPageRelative, 5, branch_on_bit<7, false>)},
+      {0x80, Instruction("BRA", PCRelative, 3, branch_always)},
+      {0x81, write_op<ZeroPageIndexedIndirect, STA>(6)},
+      {0x84, write_op<ZeroPage, STY>(3)},
+      {0x85, write_op<ZeroPage, STA>(3)},
+      {0x86, write_op<ZeroPage, STX>(3)},
+      {0x87, modify_op<ZeroPage, SMB<0>>(5)},
+      {0x88, implied_op<Implied, DEY>(2)},
+      {0x89, read_op<Immediate, BITImmediate>(2)},
+      {0x8A, implied_op<Implied, TXA>(2)},
+      {0x8C, write_op<Absolute, STY>(4)},
+      {0x8D, write_op<Absolute, STA>(4)},
+      {0x8E, write_op<Absolute, STX>(4)},
+      {0x8F, Instruction("BBS0", ZeroPageRelative, 5, branch_on_bit<0, true>)},
+      {0x90, Instruction("BCC", PCRelative, 2, branch<psr_bit::carry, false>)},
+      {0x91, write_op<ZeroPageIndirectIndexedY, STA>(6)},
+      {0x92, write_op<ZeroPageIndirect, STA>(5)},
+      {0x94, write_op<ZeroPageIndexedX, STY>(4)},
+      {0x95, write_op<ZeroPageIndexedX, STA>(4)},
+      {0x96, write_op<ZeroPageIndexedY, STX>(4)},
+      {0x97, modify_op<ZeroPage, SMB<1>>(5)},
+      {0x98, implied_op<Implied, TYA>(2)},
+      {0x99, write_op<AbsoluteIndexedY, STA>(5)},
+      {0x9A, implied_op<Implied, TXS>(2)},
+      {0x9C, write_op<Absolute, STZ>(4)},
+      {0x9D, write_op<AbsoluteIndexedX, STA>(5)},
+      {0x9E, write_op<AbsoluteIndexedX, STZ>(5)},
+      {0x9F, Instruction("BBS1", ZeroPageRelative, 5, branch_on_bit<1, true>)},
+      {0xA0, read_op<Immediate, LDY>(2)},
+      {0xA1, read_op<ZeroPageIndexedIndirect, LDA>(6)},
+      {0xA2, read_op<Immediate, LDX>(2)},
+      {0xA4, read_op<ZeroPage, LDY>(3)},
+      {0xA5, read_op<ZeroPage, LDA>(3)},
+      {0xA6, read_op<ZeroPage, LDX>(3)},
+      {0xA7, modify_op<ZeroPage, SMB<2>>(5)},
+      {0xA8, implied_op<Implied, TAY>(2)},
+      {0xA9, read_op<Immediate, LDA>(2)},
+      {0xAA, implied_op<Implied, TAX>(2)},
+      {0xAC, read_op<Absolute, LDY>(4)},
+      {0xAD, read_op<Absolute, LDA>(4)},
+      {0xAE, read_op<Absolute, LDX>(4)},
+      {0xAF, Instruction("BBS2", ZeroPageRelative, 5, branch_on_bit<2, true>)},
+      {0xB0, Instruction("BCS", PCRelative, 2, branch<psr_bit::carry, true>)},
+      {0xB1, read_op<ZeroPageIndirectIndexedY, LDA>(5)},
+      {0xB2, read_op<ZeroPageIndirect, LDA>(5)},
+      {0xB4, read_op<ZeroPageIndexedX, LDY>(4)},
+      {0xB5, read_op<ZeroPageIndexedX, LDA>(4)},
+      {0xB6, read_op<ZeroPageIndexedY, LDX>(4)},
+      {0xB7, modify_op<ZeroPage, SMB<3>>(5)},
+      {0xB8, implied_op<Implied, CLV>(2)},
+      {0xB9, read_op<AbsoluteIndexedY, LDA>(4)},
+      {0xBA, implied_op<Implied, TSX>(2)},
+      {0xBC, read_op<AbsoluteIndexedX, LDY>(4)},
+      {0xBD, read_op<AbsoluteIndexedX, LDA>(4)},
+      {0xBE, read_op<AbsoluteIndexedY, LDX>(4)},
+      {0xBF, Instruction("BBS3", ZeroPageRelative, 5, branch_on_bit<3, true>)},
+      {0xC0, read_op<Immediate, CPY>(2)},
+      {0xC1, read_op<ZeroPageIndexedIndirect, CMP>(6)},
+      {0xC4, read_op<ZeroPage, CPY>(3)},
+      {0xC5, read_op<ZeroPage, CMP>(3)},
+      {0xC6, modify_op<ZeroPage, DEC>(5)},
+      {0xC7, modify_op<ZeroPage, SMB<4>>(5)},
+      {0xC8, implied_op<Implied, INY>(2)},
+      {0xC9, read_op<Immediate, CMP>(2)},
+      {0xCA, implied_op<Implied, DEX>(2)},
+      {0xCB, Instruction("WAI", Implied, 3, wait_interrupt)},
+      {0xCC, read_op<Absolute, CPY>(4)},
+      {0xCD, read_op<Absolute, CMP>(4)},
+      {0xCE, modify_op<Absolute, DEC>(6)},
+      {0xCF, Instruction("BBS4", ZeroPageRelative, 5, branch_on_bit<4, true>)},
+      {0xD0, Instruction("BNE", PCRelative, 2, branch<psr_bit::zero, false>)},
+      {0xD1, read_op<ZeroPageIndirectIndexedY, CMP>(5)},
+      {0xD2, read_op<ZeroPageIndirect, CMP>(5)},
+      {0xD5, read_op<ZeroPageIndexedX, CMP>(4)},
+      {0xD6, modify_op<ZeroPageIndexedX, DEC>(6)},
+      {0xD7, modify_op<ZeroPage, SMB<5>>(5)},
+      {0xD8, implied_op<Implied, CLD>(2)},
+      {0xD9, read_op<AbsoluteIndexedY, CMP>(4)},
+      {0xDA, implied_op<Stack, PHX>(3)},
+      {0xDB, Instruction("STP", Implied, 3, stop)},
+      {0xDD, read_op<AbsoluteIndexedX, CMP>(4)},
+      {0xDE, modify_op<AbsoluteIndexedX, DEC>(7)},
+      {0xDF, Instruction("BBS5", ZeroPageRelative, 5, branch_on_bit<5, true>)},
+      {0xE0, read_op<Immediate, CPX>(2)},
+      {0xE1, read_op<ZeroPageIndexedIndirect, SBC>(6)},
+      {0xE4, read_op<ZeroPage, CPX>(3)},
+      {0xE5, read_op<ZeroPage, SBC>(3)},
+      {0xE6, modify_op<ZeroPage, INC>(5)},
+      {0xE7, modify_op<ZeroPage, SMB<6>>(5)},
+      {0xE8, implied_op<Implied, INX>(2)},
+      {0xE9, read_op<Immediate, SBC>(2)},
+      {0xEA, implied_op<Implied, NOP>(2)},
+      {0xEC, read_op<Absolute, CPX>(4)},
+      {0xED, read_op<Absolute, SBC>(4)},
+      {0xEE, modify_op<Absolute, INC>(6)},
+      {0xEF, Instruction("BBS6", ZeroPageRelative, 5, branch_on_bit<6, true>)},
+      {0xF0, Instruction("BEQ", PCRelative, 2, branch<psr_bit::zero, true>)},
+      {0xF1, read_op<ZeroPageIndirectIndexedY, SBC>(5)},
+      {0xF2, read_op<ZeroPageIndirect, SBC>(5)},
+      {0xF5, read_op<ZeroPageIndexedX, SBC>(4)},
+      {0xF6, modify_op<ZeroPageIndexedX, INC>(6)},
+      {0xF7, modify_op<ZeroPage, SMB<7>>(5)},
+      {0xF8, implied_op<Implied, SED>(2)},
+      {0xF9, read_op<AbsoluteIndexedY, SBC>(4)},
+      {0xFA, implied_op<Stack, PLX>(4)},
+      {0xFD, read_op<AbsoluteIndexedX, SBC>(4)},
+      {0xFE, modify_op<AbsoluteIndexedX, INC>(7)},
+      {0xFF, Instruction("BBS7", ZeroPageRelative, 5, branch_on_bit<7, true>)}
+  });
+}
+
+} // namespace isa_detail
+
+/**
+ * The table lives in the header so that an execution core can look up a
+ * handler with a constant opcode at compile time and inline it.
+ */
+inline constexpr CPU6502ISA isa = isa_detail::build_isa();
+
+/**
+ * Can the instruction jump or branch to itself? Only direct jumps and
+ * branches are counted, an indirect jump reads its target from memory that
+ * may change.
+ */
+constexpr bool may_jump_to_itself(const Instruction &instruction) {
+  return instruction.mode == AddressingMode::PCRelative ||
+         instruction.mode == AddressingMode::ZeroPageRelative ||
+         (instruction.mnemonic == mnemonic_index("JMP") &&
+          instruction.mode == AddressingMode::Absolute);
+}
+
+/**
+ * Does the instruction only change registers and flags, reading memory (if
+ * at all) at an address given by its operand? Running a loop of such
+ * instructions twice from the same registers does the same thing both
+ * times, as long as none of them reads a device.
+ */
+constexpr bool is_side_effect_free(const Instruction &instruction) {
+  if (may_jump_to_itself(instruction)) {
+    return true;
+  }
+
+  switch (instruction.mode) {
+  case AddressingMode::Absolute:
+  case AddressingMode::Immediate:
+  case AddressingMode::Implied:
+  case AddressingMode::ZeroPage:
+    break;
+  default:
+    return false;
+  }
+
+  switch (instruction.mnemonic) {
+  case mnemonic_index("AND"):
+  case mnemonic_index("BIT"):
+  case mnemonic_index("CLC"):
+  case mnemonic_index("CLV"):
+  case mnemonic_index("CMP"):
+  case mnemonic_index("CPX"):
+  case mnemonic_index("CPY"):
+  case mnemonic_index("EOR"):
+  case mnemonic_index("LDA"):
+  case mnemonic_index("LDX"):
+  case mnemonic_index("LDY"):
+  case mnemonic_index("NOP"):
+  case mnemonic_index("ORA"):
+  case mnemonic_index("SEC"):
+  case mnemonic_index("TAX"):
+  case mnemonic_index("TAY"):
+  case mnemonic_index("TXA"):
+  case mnemonic_index("TYA"):
+    return true;
+  default:
+    return false;
+  }
+}
 
 #endif
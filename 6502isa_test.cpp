@@ -0,0 +1,408 @@
+#include "6502isa.h"
+#include "6502cpu.h"
+#include "address.h"
+#include "instruction_types.h"
+#include "psr.h"
+#include "unit_test.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <initializer_list>
+#include <string>
+
+/// Put @p bytes at @ref TEST_CODE and execute the instruction there.
+static InstructionErr execute(TestMachine &machine,
+                              std::initializer_list<uint8_t> bytes) {
+  machine.load(TEST_CODE, bytes);
+  machine.cpu.set_PC(address(TEST_CODE));
+
+  return machine.cpu.step();
+}
+
+static uint8_t read(const TestMachine &machine, uint16_t at) {
+  return std::to_integer<uint8_t>(machine.bus.read(address(at)));
+}
+
+/// The N, V, Z and C flags of the CPU, as a string like "NvZc".
+static std::string flags(const TestMachine &machine) {
+  const PSR *psr = machine.cpu.get_PSR();
+
+  return std::format("{}{}{}{}", psr->get_bit(psr_bit::negative) ? 'N' : 'n',
+                     psr->get_bit(psr_bit::overflow) ? 'V' : 'v',
+                     psr->get_bit(psr_bit::zero) ? 'Z' : 'z',
+                     psr->get_bit(psr_bit::carry) ? 'C' : 'c');
+}
+
+/**
+ * The (zp) opcodes operate on the memory the zero-page pointer points to,
+ * not on the pointer itself.
+ */
+static void check_zero_page_indirect() {
+  struct Case {
+    uint8_t opcode;
+    /// A after the instruction, or the stored byte for STA.
+    uint8_t result;
+  };
+
+  // A = 0F, the pointer at 10 points to 3000, which holds 5A
+  constexpr Case CASES[] = {{0x12, 0x5F}, {0x32, 0x0A}, {0x52, 0x55},
+                            {0x72, 0x69}, {0x92, 0x0F}, {0xB2, 0x5A}};
+
+  for (const Case &c : CASES) {
+    TestMachine machine;
+    machine.load(0x0010, {0x00, 0x30});
+    machine.load(0x3000, {0x5A});
+    machine.cpu.set_A(std::byte{0x0F});
+
+    execute(machine, {c.opcode, 0x10});
+
+    uint8_t result = c.opcode == 0x92
+                         ? read(machine, 0x3000)
+                         : std::to_integer<uint8_t>(machine.cpu.get_A());
+
+    check(result == c.result &&
+              machine.cpu.get_PC() == address(TEST_CODE + 2),
+          std::format("{} (zp) gives {}, expected {}",
+                      isa[c.opcode].name(), static_cast<int>(result),
+                      static_cast<int>(c.result)));
+  }
+}
+
+/// A zero-page pointer at FF takes its high byte from 00, not from 0100.
+static void check_zero_page_pointer_wrap() {
+  struct Case {
+    const char *what;
+    std::initializer_list<uint8_t> bytes;
+    uint8_t expected;
+  };
+
+  const Case cases[] = {{"LDA (FF)", {0xB2, 0xFF}, 0x11},
+                        {"LDA (FE,X)", {0xA1, 0xFE}, 0x11},
+                        {"LDA (FF),Y", {0xB1, 0xFF}, 0x22}};
+
+  for (const Case &c : cases) {
+    TestMachine machine;
+    // the pointer is 3000 when it wraps and 4000 when it does not
+    machine.load(0x00FF, {0x00});
+    machine.load(0x0000, {0x30});
+    machine.load(0x0100, {0x40});
+    machine.load(0x3000, {0x11, 0x22});
+    machine.load(0x4000, {0x33, 0x44});
+    machine.cpu.set_X(std::byte{0x01});
+    machine.cpu.set_Y(std::byte{0x01});
+
+    execute(machine, c.bytes);
+
+    check(machine.cpu.get_A() == std::byte(c.expected),
+          std::format("{} reads {}, expected {}", c.what,
+                      std::to_integer<int>(machine.cpu.get_A()),
+                      static_cast<int>(c.expected)));
+  }
+}
+
+/**
+ * BBRx and BBSx are three bytes long: they test a bit of a zero-page
+ * location and branch relative to the next instruction.
+ */
+static void check_branch_on_bit() {
+  for (int bit = 0; bit < 8; ++bit) {
+    for (int set = 0; set < 2; ++set) {
+      for (int value_set = 0; value_set < 2; ++value_set) {
+        uint8_t opcode = static_cast<uint8_t>((set ? 0x8F : 0x0F) | bit << 4);
+        // every bit but the one tested is the opposite
+        uint8_t value = static_cast<uint8_t>(value_set ? 1 << bit
+                                                       : ~(1 << bit));
+
+        TestMachine machine;
+        machine.load(0x0042, {value});
+
+        execute(machine, {opcode, 0x42, 0x10});
+
+        bool taken = value_set == set;
+        address expected(TEST_CODE + 3 + (taken ? 0x10 : 0));
+
+        if (!check(machine.cpu.get_PC() == expected,
+                   std::format("{} with {} continues at {}, expected {}",
+                               isa[opcode].name(), static_cast<int>(value),
+                               machine.cpu.get_PC().inner(),
+                               expected.inner()))) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * CMP, CPX and CPY set C when the register is not lower than the operand, Z
+ * when they are equal and N from the difference, in every addressing mode.
+ */
+static void check_compare() {
+  struct Case {
+    uint8_t opcode;
+    /// The register compared, set to @ref REGISTER.
+    void (CPU6502::*set)(std::byte);
+  };
+
+  const Case cases[] = {
+      {0xC9, &CPU6502::set_A}, {0xC5, &CPU6502::set_A},
+      {0xCD, &CPU6502::set_A}, {0xD2, &CPU6502::set_A},
+      {0xE0, &CPU6502::set_X}, {0xE4, &CPU6502::set_X},
+      {0xEC, &CPU6502::set_X}, {0xC0, &CPU6502::set_Y},
+      {0xC4, &CPU6502::set_Y}, {0xCC, &CPU6502::set_Y}};
+
+  constexpr uint8_t REGISTER = 0x40;
+
+  struct Operand {
+    uint8_t value;
+    const char *flags;
+  };
+
+  constexpr Operand OPERANDS[] = {
+      {0x40, "nvZC"}, {0x41, "Nvzc"}, {0x3F, "nvzC"}, {0xC1, "nvzc"}};
+
+  for (const Case &c : cases) {
+    for (const Operand &operand : OPERANDS) {
+      TestMachine machine;
+      // the zero-page and absolute operands are at 0010, (0020) is 0010 too
+      machine.load(0x0010, {operand.value});
+      machine.load(0x0020, {0x10, 0x00});
+      (machine.cpu.*c.set)(std::byte{REGISTER});
+
+      uint8_t location = c.opcode == 0xD2 ? 0x20 : 0x10;
+      uint8_t operand_byte = isa[c.opcode].mode == AddressingMode::Immediate
+                                 ? operand.value
+                                 : location;
+
+      execute(machine, {c.opcode, operand_byte, 0x00});
+
+      check(flags(machine) == operand.flags,
+            std::format("{} ({}) of {} with {} sets {}, expected {}",
+                        isa[c.opcode].name(), static_cast<int>(c.opcode),
+                        static_cast<int>(REGISTER),
+                        static_cast<int>(operand.value), flags(machine),
+                        operand.flags));
+    }
+  }
+}
+
+/**
+ * BIT sets Z from A AND the operand and copies N and V from the operand,
+ * except BIT #, which only sets Z.
+ */
+static void check_bit() {
+  struct Case {
+    std::initializer_list<uint8_t> bytes;
+    const char *flags;
+  };
+
+  // A = 0F, the operand is C0 and the flags start as nvzc
+  const Case cases[] = {{{0x24, 0x10}, "NVZc"},
+                        {{0x34, 0x10}, "NVZc"},
+                        {{0x2C, 0x10, 0x00}, "NVZc"},
+                        {{0x3C, 0x10, 0x00}, "NVZc"},
+                        {{0x89, 0xC0}, "nvZc"}};
+
+  for (const Case &c : cases) {
+    TestMachine machine;
+    machine.load(0x0010, {0xC0});
+    machine.cpu.set_A(std::byte{0x0F});
+    machine.cpu.set_PSR(PSR(std::byte{0x00}));
+
+    execute(machine, c.bytes);
+
+    check(flags(machine) == c.flags,
+          std::format("BIT ({}) sets {}, expected {}",
+                      static_cast<int>(*c.bytes.begin()), flags(machine),
+                      c.flags));
+  }
+}
+
+/// Loads, transfers and pulls set N and Z from the value they move.
+static void check_move_flags() {
+  struct Case {
+    std::initializer_list<uint8_t> bytes;
+  };
+
+  // A, X and Y hold the value, so does 0010 and the top of the stack
+  const Case cases[] = {{{0xAD, 0x10, 0x00}}, {{0xAA}}, {{0xA8}}, {{0x8A}},
+                        {{0x98}},             {{0x68}}, {{0xFA}}, {{0x7A}}};
+
+  for (const Case &c : cases) {
+    for (uint8_t value : {0x00, 0x80}) {
+      TestMachine machine;
+      machine.load(0x0010, {value});
+      machine.cpu.push_stack(std::byte(value));
+      machine.cpu.set_A(std::byte(value));
+      machine.cpu.set_X(std::byte(value));
+      machine.cpu.set_Y(std::byte(value));
+      machine.cpu.set_PSR(PSR(std::byte{0x00}));
+
+      execute(machine, c.bytes);
+
+      const char *expected = value == 0 ? "nvZc" : "Nvzc";
+
+      check(flags(machine) == expected,
+            std::format("{} of {} sets {}, expected {}",
+                        isa[*c.bytes.begin()].name(), static_cast<int>(value),
+                        flags(machine), expected));
+    }
+  }
+
+  // TSX moves the stack pointer
+  TestMachine machine;
+  machine.cpu.set_S(std::byte{0x80});
+  execute(machine, {0xBA});
+
+  check(flags(machine).starts_with("N"), "TSX of 80 leaves N clear");
+}
+
+/// INX, INY and DEY leave C alone when they wrap around.
+static void check_index_step_carry() {
+  struct Case {
+    uint8_t opcode;
+    uint8_t value;
+  };
+
+  constexpr Case CASES[] = {{0xE8, 0xFF}, {0xC8, 0xFF}, {0x88, 0x00}};
+
+  for (const Case &c : CASES) {
+    TestMachine machine;
+    machine.cpu.set_X(std::byte(c.value));
+    machine.cpu.set_Y(std::byte(c.value));
+    machine.cpu.set_PSR(PSR(std::byte{0x00}));
+
+    execute(machine, {c.opcode});
+
+    check(!machine.cpu.get_PSR()->get_bit(psr_bit::carry),
+          std::format("{} of {} sets C", isa[c.opcode].name(),
+                      static_cast<int>(c.value)));
+  }
+}
+
+/// LSR sets Z when the result is zero, in every addressing mode.
+static void check_lsr_zero() {
+  const std::initializer_list<uint8_t> cases[] = {
+      {0x4A}, {0x46, 0x10}, {0x56, 0x10}, {0x4E, 0x10, 0x00},
+      {0x5E, 0x10, 0x00}};
+
+  for (const std::initializer_list<uint8_t> &bytes : cases) {
+    TestMachine machine;
+    machine.load(0x0010, {0x01});
+    machine.cpu.set_A(std::byte{0x01});
+    machine.cpu.set_PSR(PSR(std::byte{0x80}));
+
+    execute(machine, bytes);
+
+    check(flags(machine) == "nvZC",
+          std::format("LSR ({}) of 01 sets {}, expected nvZC",
+                      static_cast<int>(*bytes.begin()), flags(machine)));
+  }
+}
+
+/// Pull an address from the stack, low byte first.
+static uint16_t pull_address(TestMachine &machine) {
+  auto low = std::to_integer<uint16_t>(machine.cpu.pop_stack());
+  auto high = std::to_integer<uint16_t>(machine.cpu.pop_stack());
+
+  return static_cast<uint16_t>(high << 8 | low);
+}
+
+/**
+ * JSR pushes the address of its last byte and RTS returns one past the
+ * pulled address, so pushing a target minus one and RTS jumps to it.
+ */
+static void check_subroutine_stack() {
+  TestMachine machine;
+  machine.load(0x3000, {0x60});
+
+  execute(machine, {0x20, 0x00, 0x30});
+  check(machine.cpu.get_PC() == address(0x3000), "JSR jumps to 3000");
+
+  machine.cpu.step();
+  check(machine.cpu.get_PC() == address(TEST_CODE + 3),
+        std::format("RTS returns to {}, expected {}",
+                    machine.cpu.get_PC().inner(), TEST_CODE + 3));
+
+  execute(machine, {0x20, 0x00, 0x30});
+  uint16_t pushed = pull_address(machine);
+  check(pushed == TEST_CODE + 2,
+        std::format("JSR pushes {}, expected {}", pushed, TEST_CODE + 2));
+
+  // the dispatch through the stack that jump tables use
+  machine.cpu.push_stack(std::byte{0x3F});
+  machine.cpu.push_stack(std::byte{0xFF});
+  execute(machine, {0x60});
+  check(machine.cpu.get_PC() == address(0x4000),
+        "RTS to a pushed 3FFF continues at 4000");
+}
+
+/**
+ * BRK pushes the address two bytes past itself and P with B set, sets I,
+ * clears D and jumps through FFFE. The byte after BRK is the signature byte,
+ * the one before the pushed address. RTI returns to the pushed address and,
+ * like PLP, leaves B clear in the register.
+ */
+static void check_break_stack() {
+  TestMachine machine;
+  machine.load(0xFFFE, {0x00, 0x30});
+  machine.load(0x3000, {0x40});
+  // D set, I clear
+  machine.cpu.set_PSR(PSR(std::byte{0x08}));
+
+  execute(machine, {0x00, 0xEE});
+
+  const PSR *psr = machine.cpu.get_PSR();
+
+  check(machine.cpu.get_PC() == address(0x3000), "BRK jumps through FFFE");
+  check(psr->get_bit(psr_bit::interrupt_disable) &&
+            !psr->get_bit(psr_bit::decimal_mode) &&
+            !psr->get_bit(psr_bit::break_command),
+        "BRK sets I, clears D and leaves B clear");
+
+  PSR pushed_psr(machine.cpu.pop_stack());
+  uint16_t pushed = pull_address(machine);
+
+  check(pushed_psr.get_bit(psr_bit::break_command) &&
+            pushed_psr.get_bit(psr_bit::decimal_mode) &&
+            !pushed_psr.get_bit(psr_bit::interrupt_disable),
+        "BRK pushes P as it was, with B set");
+  check(pushed == TEST_CODE + 2,
+        std::format("BRK pushes {}, expected {}", pushed, TEST_CODE + 2));
+  check(read(machine, static_cast<uint16_t>(pushed - 1)) == 0xEE,
+        "the signature byte is the one before the pushed address");
+
+  // RTI from the handler
+  machine.cpu.set_PSR(PSR(std::byte{0x08}));
+  execute(machine, {0x00, 0xEE});
+  machine.cpu.step();
+
+  check(machine.cpu.get_PC() == address(TEST_CODE + 2),
+        std::format("RTI returns to {}, expected {}",
+                    machine.cpu.get_PC().inner(), TEST_CODE + 2));
+  check(!psr->get_bit(psr_bit::break_command) &&
+            !psr->get_bit(psr_bit::interrupt_disable),
+        "RTI restores P without B");
+  check(psr->get_bit(psr_bit::decimal_mode), "RTI restores D");
+
+  // PHP pushes B set, PLP drops it
+  execute(machine, {0x08});
+  execute(machine, {0x28});
+  check(!psr->get_bit(psr_bit::break_command), "PLP leaves B clear");
+}
+
+int main() {
+  check_zero_page_indirect();
+  check_zero_page_pointer_wrap();
+  check_branch_on_bit();
+  check_compare();
+  check_bit();
+  check_move_flags();
+  check_index_step_carry();
+  check_lsr_zero();
+  check_subroutine_stack();
+  check_break_stack();
+
+  return finish_checks("6502isa");
+}
@@ -0,0 +1,836 @@
+#ifndef _H_6502OPS
+#define _H_6502OPS
+
+#include "6502cpu.h"
+#include "address.h"
+#include "byte_utils.h"
+#include "decimal.h"
+#include "instruction_types.h"
+#include "psr.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Building blocks of the instruction set.
+ *
+ * Every opcode is an instance of one of the handler templates below,
+ * parameterized by its addressing mode and by the operation it performs. The
+ * address resolution, the operation and the flag updates are therefore
+ * compiled into one function per opcode, without any runtime dispatch on the
+ * addressing mode.
+ *
+ * Each handler gets the raw operand of the instruction (the one or two bytes
+ * following the opcode) and is responsible for advancing the program counter.
+ */
+namespace ops {
+
+using enum AddressingMode;
+
+/**
+ * Read a little-endian pointer from the zero page. The high byte wraps around
+ * to the start of the zero page.
+ */
+inline address read_zp_pointer(const CPU6502 &cpu, std::byte location) {
+  return address(cpu.get_bus()->read(address(location)),
+                 cpu.get_bus()->read(address((location + 1).value)));
+}
+
+/// Read a little-endian pointer from anywhere in the memory.
+inline address read_pointer(const CPU6502 &cpu, address location) {
+  return address(cpu.get_bus()->read(location),
+                 cpu.get_bus()->read((location + 1).value));
+}
+
+/**
+ * Can indexing cross a page in the addressing mode? Reads (and some
+ * read-modify-write instructions) then take an extra cycle.
+ */
+constexpr bool has_page_penalty(AddressingMode mode) {
+  return mode == AbsoluteIndexedX || mode == AbsoluteIndexedY ||
+         mode == ZeroPageIndirectIndexedY;
+}
+
+/// The index register added to the address, see @ref has_page_penalty.
+template <AddressingMode Mode> inline std::byte index(const CPU6502 &cpu) {
+  if constexpr (Mode == AbsoluteIndexedX) {
+    return cpu.get_X();
+  } else {
+    return cpu.get_Y();
+  }
+}
+
+/// The address before indexing, see @ref has_page_penalty.
+template <AddressingMode Mode>
+inline address index_base(const CPU6502 &cpu, address operand) {
+  if constexpr (Mode == ZeroPageIndirectIndexedY) {
+    return read_zp_pointer(cpu, operand.low());
+  } else {
+    return operand;
+  }
+}
+
+/**
+ * Resolve the address the instruction operates on, counting the extra cycle
+ * if indexing crosses a page.
+ */
+template <AddressingMode Mode>
+inline address indexed_address(CPU6502 &cpu, address operand) {
+  address base = index_base<Mode>(cpu, operand);
+  address target = (base + index<Mode>(cpu)).value;
+
+  if (crosses_page(base, target)) {
+    cpu.count_cycles(1);
+  }
+
+  return target;
+}
+
+/**
+ * Resolve the address the instruction operates on.
+ *
+ * @tparam Mode The addressing mode of the instruction.
+ * @param operand The raw operand of the instruction.
+ */
+template <AddressingMode Mode>
+inline address effective_address(const CPU6502 &cpu, address operand) {
+  if constexpr (Mode == ZeroPage) {
+    return address(operand.low());
+  } else if constexpr (Mode == ZeroPageIndexedX) {
+    return address((operand.low() + cpu.get_X()).value);
+  } else if constexpr (Mode == ZeroPageIndexedY) {
+    return address((operand.low() + cpu.get_Y()).value);
+  } else if constexpr (Mode == Absolute) {
+    return operand;
+  } else if constexpr (has_page_penalty(Mode)) {
+    return (index_base<Mode>(cpu, operand) + index<Mode>(cpu)).value;
+  } else if constexpr (Mode == ZeroPageIndexedIndirect) {
+    return read_zp_pointer(cpu, (operand.low() + cpu.get_X()).value);
+  } else if constexpr (Mode == ZeroPageIndirect) {
+    return read_zp_pointer(cpu, operand.low());
+  } else if constexpr (Mode == AbsoluteIndirect) {
+    return read_pointer(cpu, operand);
+  } else if constexpr (Mode == AbsoluteIndexedIndirect) {
+    return read_pointer(cpu, (operand + cpu.get_X()).value);
+  } else {
+    static_assert(Mode == Absolute, "Addressing mode does not use memory.");
+  }
+}
+
+/**
+ * Fetch the value the instruction operates on. Immediate and accumulator
+ * operands never touch the memory.
+ */
+template <AddressingMode Mode>
+inline std::byte read_operand(const CPU6502 &cpu, address operand) {
+  if constexpr (Mode == Immediate) {
+    return operand.low();
+  } else if constexpr (Mode == Accumulator) {
+    return cpu.get_A();
+  } else {
+    return cpu.get_bus()->read(effective_address<Mode>(cpu, operand));
+  }
+}
+
+/// Move the program counter past the current instruction.
+template <AddressingMode Mode> inline void advance(CPU6502 &cpu) {
+  constexpr uint16_t bytes = bytes_for_addressing_mode(Mode);
+
+  cpu.set_PC((cpu.get_PC() + bytes).value);
+}
+
+/// Target of a relative branch, `offset` counts from the next instruction.
+template <AddressingMode Mode>
+inline address branch_target(const CPU6502 &cpu, std::byte offset) {
+  constexpr uint16_t bytes = bytes_for_addressing_mode(Mode);
+
+  return address(cpu.get_PC().inner() + bytes +
+                 static_cast<int8_t>(offset));
+}
+
+// Handlers
+
+/**
+ * Instructions that read an operand: loads, arithmetic, logic, comparisons.
+ * Indexed reads take a cycle longer when indexing crosses a page.
+ */
+template <AddressingMode Mode, typename Op>
+InstructionErr read(CPU6502 &cpu, address operand) {
+  if constexpr (has_page_penalty(Mode)) {
+    Op::apply(cpu, cpu.get_bus()->read(indexed_address<Mode>(cpu, operand)));
+  } else {
+    Op::apply(cpu, read_operand<Mode>(cpu, operand));
+  }
+
+  advance<Mode>(cpu);
+
+  return InstructionErr::OK;
+}
+
+/// Instructions that store a register to memory.
+template <AddressingMode Mode, typename Op>
+InstructionErr write(CPU6502 &cpu, address operand) {
+  cpu.get_bus()->write(effective_address<Mode>(cpu, operand),
+                          Op::value(cpu));
+  advance<Mode>(cpu);
+
+  return InstructionErr::OK;
+}
+
+/**
+ * Read-modify-write instructions, either on the accumulator or in memory.
+ * The shifts and rotations take a cycle longer when indexing crosses a page
+ * (see `Op::PAGE_PENALTY`), INC and DEC always take their full time.
+ */
+template <AddressingMode Mode, typename Op>
+InstructionErr modify(CPU6502 &cpu, address operand) {
+  if constexpr (Mode == Accumulator) {
+    cpu.set_A(Op::apply(cpu, cpu.get_A()));
+  } else {
+    address target;
+
+    if constexpr (has_page_penalty(Mode) && requires { Op::PAGE_PENALTY; }) {
+      target = indexed_address<Mode>(cpu, operand);
+    } else {
+      target = effective_address<Mode>(cpu, operand);
+    }
+
+    cpu.get_bus()->write(target,
+                            Op::apply(cpu, cpu.get_bus()->read(target)));
+  }
+
+  advance<Mode>(cpu);
+
+  return InstructionErr::OK;
+}
+
+/// Instructions without an operand (transfers, flag changes, stack, ...).
+template <AddressingMode Mode, typename Op>
+InstructionErr implied(CPU6502 &cpu, address) {
+  Op::apply(cpu);
+  advance<Mode>(cpu);
+
+  return InstructionErr::OK;
+}
+
+/**
+ * Cycles a branch to @p target takes on top of its base cycles: one if it is
+ * taken, and one more if @p target is on another page than the following
+ * instruction.
+ *
+ * @tparam Taken Whether the base cycles already include the taken branch (BRA).
+ */
+template <AddressingMode Mode, bool Taken = false>
+inline uint8_t branch_cycles(const CPU6502 &cpu, address target) {
+  constexpr uint16_t bytes = bytes_for_addressing_mode(Mode);
+
+  address next = (cpu.get_PC() + bytes).value;
+
+  return static_cast<uint8_t>((Taken ? 0 : 1) + crosses_page(next, target));
+}
+
+/// Jump to the target of a taken relative branch, counting its cycles.
+template <AddressingMode Mode, bool Taken = false>
+inline InstructionErr take_branch(CPU6502 &cpu, std::byte offset) {
+  address target = branch_target<Mode>(cpu, offset);
+
+  cpu.count_cycles(branch_cycles<Mode, Taken>(cpu, target));
+  cpu.set_PC(target);
+
+  return InstructionErr::OKPCModified;
+}
+
+/// Conditional branches, taken when `Flag` equals `Set`.
+template <psr_bit Flag, bool Set>
+InstructionErr branch(CPU6502 &cpu, address operand) {
+  if (cpu.get_PSR()->get_bit(Flag) == Set) {
+    return take_branch<PCRelative>(cpu, operand.low());
+  }
+
+  advance<PCRelative>(cpu);
+
+  return InstructionErr::OK;
+}
+
+/// BRA, the unconditional relative branch.
+inline InstructionErr branch_always(CPU6502 &cpu, address operand) {
+  return take_branch<PCRelative, true>(cpu, operand.low());
+}
+
+/**
+ * BBRx/BBSx, branch if bit `Bit` of a zero page location equals `Set`. The
+ * first operand byte is the location, the second is the branch offset.
+ */
+template <int Bit, bool Set>
+InstructionErr branch_on_bit(CPU6502 &cpu, address operand) {
+  std::byte value = cpu.get_bus()->read(address(operand.low()));
+
+  if (is_bit_set(value, Bit) == Set) {
+    return take_branch<ZeroPageRelative>(cpu, operand.high());
+  }
+
+  advance<ZeroPageRelative>(cpu);
+
+  return InstructionErr::OK;
+}
+
+template <AddressingMode Mode>
+InstructionErr jump(CPU6502 &cpu, address operand) {
+  if constexpr (Mode == Absolute) {
+    cpu.set_PC(operand);
+  } else {
+    cpu.set_PC(effective_address<Mode>(cpu, operand));
+  }
+
+  return InstructionErr::OKPCModified;
+}
+
+/**
+ * Pull the status register from the stack. The B bit only exists in the
+ * pushed copies, it is never set in the register.
+ */
+inline PSR pull_status(CPU6502 &cpu) {
+  PSR psr(cpu.pop_stack());
+  psr.set_bit(psr_bit::break_command, false);
+
+  return psr;
+}
+
+inline InstructionErr jump_subroutine(CPU6502 &cpu, address operand) {
+  // push the address of the last byte of JSR, high part first
+  address last = (cpu.get_PC() + 2).value;
+
+  cpu.push_stack(last.high());
+  cpu.push_stack(last.low());
+
+  cpu.set_PC(operand);
+
+  return InstructionErr::OKPCModified;
+}
+
+inline InstructionErr return_subroutine(CPU6502 &cpu, address) {
+  auto low = cpu.pop_stack();
+  auto high = cpu.pop_stack();
+  cpu.set_PC((address(low, high) + 1).value);
+
+  return InstructionErr::OKPCModified;
+}
+
+inline InstructionErr break_interrupt(CPU6502 &cpu, address) {
+  // the byte after BRK is skipped, the handler returns past it
+  cpu.set_PC((cpu.get_PC() + 2).value);
+  cpu.interrupt(address(IRQ_VECTOR), true);
+
+  return InstructionErr::OKPCModified;
+}
+
+inline InstructionErr return_interrupt(CPU6502 &cpu, address) {
+  cpu.set_PSR(pull_status(cpu));
+
+  auto low = cpu.pop_stack();
+  auto high = cpu.pop_stack();
+  cpu.set_PC(address(low, high));
+
+  return InstructionErr::OKPCModified;
+}
+
+inline InstructionErr stop(CPU6502 &cpu, address) {
+  advance<Implied>(cpu);
+
+  return InstructionErr::Stop;
+}
+
+/**
+ * WAI. If the cycle limit of the run comes before an interrupt, the program
+ * counter stays on WAI, so the next run waits again.
+ */
+inline InstructionErr wait_interrupt(CPU6502 &cpu, address) {
+  if (!cpu.wait_for_interrupt()) {
+    return InstructionErr::OKPCModified;
+  }
+
+  advance<Implied>(cpu);
+
+  return InstructionErr::OK;
+}
+
+/**
+ * `DBG` always leaves the core, the run loop decides whether to go to the
+ * debugger or on (see @ref RunPolicy).
+ */
+inline InstructionErr debug_break(CPU6502 &cpu, address) {
+  advance<Implied>(cpu);
+
+  return InstructionErr::GoToDebugger;
+}
+
+// Operations
+
+/**
+ * ADC or SBC in decimal mode, looked up in @p table. Takes a cycle longer than
+ * in binary mode.
+ */
+inline void decimal_arithmetic(CPU6502 &cpu, const DecimalTable &table,
+                               std::byte operand) {
+  const DecimalResult &result =
+      table[decimal_index(cpu.get_PSR()->get_bit(psr_bit::carry),
+                          std::to_integer<uint8_t>(cpu.get_A()),
+                          std::to_integer<uint8_t>(operand))];
+
+  cpu.count_cycles(1);
+
+  cpu.get_PSR()->set_bit(psr_bit::carry, (result.flags & DECIMAL_CARRY) != 0);
+  cpu.get_PSR()->set_overflow_from(std::byte(result.flags));
+
+  cpu.set_A(std::byte(result.value));
+  cpu.update_flags(std::byte(result.value));
+}
+
+struct ADC {
+  static constexpr const char *NAME = "ADC";
+
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    if (cpu.get_PSR()->get_bit(psr_bit::decimal_mode)) [[unlikely]] {
+      decimal_arithmetic(cpu, DECIMAL_ADC, operand);
+
+      return;
+    }
+
+    std::byte accumulator = cpu.get_A();
+
+    auto result =
+        accumulator + operand + cpu.get_PSR()->get_bit(psr_bit::carry);
+
+    cpu.get_PSR()->set_bit(psr_bit::carry, result.carry);
+    cpu.get_PSR()->set_overflow_from((accumulator ^ result.value) &
+                                     (operand ^ result.value));
+
+    cpu.set_A(result.value);
+    cpu.update_flags(result.value);
+  }
+};
+
+struct SBC {
+  static constexpr const char *NAME = "SBC";
+
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    if (cpu.get_PSR()->get_bit(psr_bit::decimal_mode)) [[unlikely]] {
+      decimal_arithmetic(cpu, DECIMAL_SBC, operand);
+
+      return;
+    }
+
+    bool borrow = !cpu.get_PSR()->get_bit(psr_bit::carry);
+
+    uint8_t a = std::to_integer<uint8_t>(cpu.get_A());
+    uint8_t m = std::to_integer<uint8_t>(operand);
+
+    std::byte result = std::byte(static_cast<uint8_t>(a - m - borrow));
+
+    cpu.get_PSR()->set_bit(psr_bit::carry, a >= m + borrow);
+    cpu.get_PSR()->set_overflow_from((cpu.get_A() ^ result) &
+                                     (cpu.get_A() ^ operand));
+
+    cpu.set_A(result);
+    cpu.update_flags(result);
+  }
+};
+
+struct AND {
+  static constexpr const char *NAME = "AND";
+
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    cpu.set_A(cpu.get_A() & operand);
+    cpu.update_flags(cpu.get_A());
+  }
+};
+
+struct ORA {
+  static constexpr const char *NAME = "ORA";
+
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    cpu.set_A(cpu.get_A() | operand);
+    cpu.update_flags(cpu.get_A());
+  }
+};
+
+struct EOR {
+  static constexpr const char *NAME = "EOR";
+
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    cpu.set_A(cpu.get_A() ^ operand);
+    cpu.update_flags(cpu.get_A());
+  }
+};
+
+/// CMP, CPX and CPY: compare a register with the operand.
+template <std::byte (CPU6502::*Register)() const> struct Compare {
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    std::byte value = (cpu.*Register)();
+
+    cpu.get_PSR()->set_bit(psr_bit::carry, value >= operand);
+    cpu.update_flags((value - operand).value);
+  }
+};
+
+struct CMP : Compare<&CPU6502::get_A> {
+  static constexpr const char *NAME = "CMP";
+};
+
+struct CPX : Compare<&CPU6502::get_X> {
+  static constexpr const char *NAME = "CPX";
+};
+
+struct CPY : Compare<&CPU6502::get_Y> {
+  static constexpr const char *NAME = "CPY";
+};
+
+struct BIT {
+  static constexpr const char *NAME = "BIT";
+
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    cpu.get_PSR()->set_zero_from(cpu.get_A() & operand);
+    cpu.get_PSR()->set_overflow_from(operand << 1);
+    cpu.get_PSR()->set_negative_from(operand);
+  }
+};
+
+/// BIT with an immediate operand only affects the zero flag.
+struct BITImmediate {
+  static constexpr const char *NAME = "BIT";
+
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    cpu.get_PSR()->set_zero_from(cpu.get_A() & operand);
+  }
+};
+
+/// LDA, LDX and LDY: load a register with the operand.
+template <void (CPU6502::*Register)(std::byte)> struct Load {
+  static void apply(CPU6502 &cpu, std::byte operand) {
+    (cpu.*Register)(operand);
+    cpu.update_flags(operand);
+  }
+};
+
+struct LDA : Load<&CPU6502::set_A> {
+  static constexpr const char *NAME = "LDA";
+};
+
+struct LDX : Load<&CPU6502::set_X> {
+  static constexpr const char *NAME = "LDX";
+};
+
+struct LDY : Load<&CPU6502::set_Y> {
+  static constexpr const char *NAME = "LDY";
+};
+
+/// STA, STX and STY: store a register.
+template <std::byte (CPU6502::*Register)() const> struct Store {
+  static std::byte value(const CPU6502 &cpu) { return (cpu.*Register)(); }
+};
+
+struct STA : Store<&CPU6502::get_A> {
+  static constexpr const char *NAME = "STA";
+};
+
+struct STX : Store<&CPU6502::get_X> {
+  static constexpr const char *NAME = "STX";
+};
+
+struct STY : Store<&CPU6502::get_Y> {
+  static constexpr const char *NAME = "STY";
+};
+
+struct STZ {
+  static constexpr const char *NAME = "STZ";
+
+  static std::byte value(const CPU6502 &) { return ZERO_BYTE; }
+};
+
+struct ASL {
+  static constexpr const char *NAME = "ASL";
+  static constexpr bool PAGE_PENALTY = true;
+
+  static std::byte apply(CPU6502 &cpu, std::byte value) {
+    cpu.get_PSR()->set_bit(psr_bit::carry, is_negative(value));
+
+    value = value << 1;
+    cpu.update_flags(value);
+
+    return value;
+  }
+};
+
+struct LSR {
+  static constexpr const char *NAME = "LSR";
+  static constexpr bool PAGE_PENALTY = true;
+
+  static std::byte apply(CPU6502 &cpu, std::byte value) {
+    cpu.get_PSR()->set_bit(psr_bit::carry, (value & LS_BIT_MASK) != ZERO_BYTE);
+
+    value = value >> 1;
+    cpu.update_flags(value);
+
+    return value;
+  }
+};
+
+struct ROL {
+  static constexpr const char *NAME = "ROL";
+  static constexpr bool PAGE_PENALTY = true;
+
+  static std::byte apply(CPU6502 &cpu, std::byte value) {
+    bool carry_out = is_negative(value);
+
+    value = (value << 1) | std::byte(cpu.get_PSR()->get_bit(psr_bit::carry));
+
+    cpu.get_PSR()->set_bit(psr_bit::carry, carry_out);
+    cpu.update_flags(value);
+
+    return value;
+  }
+};
+
+struct ROR {
+  static constexpr const char *NAME = "ROR";
+  static constexpr bool PAGE_PENALTY = true;
+
+  static std::byte apply(CPU6502 &cpu, std::byte value) {
+    bool carry_out = (value & LS_BIT_MASK) != ZERO_BYTE;
+
+    value =
+        (value >> 1) | (std::byte(cpu.get_PSR()->get_bit(psr_bit::carry)) << 7);
+
+    cpu.get_PSR()->set_bit(psr_bit::carry, carry_out);
+    cpu.update_flags(value);
+
+    return value;
+  }
+};
+
+struct INC {
+  static constexpr const char *NAME = "INC";
+
+  static std::byte apply(CPU6502 &cpu, std::byte value) {
+    value = (value + 1).value;
+    cpu.update_flags(value);
+
+    return value;
+  }
+};
+
+struct DEC {
+  static constexpr const char *NAME = "DEC";
+
+  static std::byte apply(CPU6502 &cpu, std::byte value) {
+    value = (value - 1).value;
+    cpu.update_flags(value);
+
+    return value;
+  }
+};
+
+struct TSB {
+  static constexpr const char *NAME = "TSB";
+
+  static std::byte apply(CPU6502 &cpu, std::byte value) {
+    cpu.get_PSR()->set_zero_from(value & cpu.get_A());
+
+    return value | cpu.get_A();
+  }
+};
+
+struct TRB {
+  static constexpr const char *NAME = "TRB";
+
+  static std::byte apply(CPU6502 &cpu, std::byte value) {
+    cpu.get_PSR()->set_zero_from(value & cpu.get_A());
+
+    return value & ~cpu.get_A();
+  }
+};
+
+/// RMBx/SMBx, reset or set bit `Bit` of a zero page location.
+template <int Bit, bool Set> struct MemoryBit {
+  static std::byte apply(CPU6502 &, std::byte value) {
+    if constexpr (Set) {
+      return value | std::byte(1 << Bit);
+    } else {
+      return value & ~std::byte(1 << Bit);
+    }
+  }
+};
+
+template <int Bit> struct RMB : MemoryBit<Bit, false> {
+  static constexpr const char *NAME = MNEMONICS[mnemonic_index("RMB0") + Bit];
+};
+
+template <int Bit> struct SMB : MemoryBit<Bit, true> {
+  static constexpr const char *NAME = MNEMONICS[mnemonic_index("SMB0") + Bit];
+};
+
+/// INX, INY, DEX, DEY: step an index register by one.
+template <std::byte (CPU6502::*Get)() const, void (CPU6502::*Set)(std::byte),
+          uint8_t Delta>
+struct Step {
+  static void apply(CPU6502 &cpu) {
+    std::byte value = ((cpu.*Get)() + Delta).value;
+
+    (cpu.*Set)(value);
+    cpu.update_flags(value);
+  }
+};
+
+struct INX : Step<&CPU6502::get_X, &CPU6502::set_X, 1> {
+  static constexpr const char *NAME = "INX";
+};
+
+struct INY : Step<&CPU6502::get_Y, &CPU6502::set_Y, 1> {
+  static constexpr const char *NAME = "INY";
+};
+
+struct DEX : Step<&CPU6502::get_X, &CPU6502::set_X, 0xFF> {
+  static constexpr const char *NAME = "DEX";
+};
+
+struct DEY : Step<&CPU6502::get_Y, &CPU6502::set_Y, 0xFF> {
+  static constexpr const char *NAME = "DEY";
+};
+
+/// Register transfers. All of them but TXS update the flags.
+template <std::byte (CPU6502::*Get)() const, void (CPU6502::*Set)(std::byte),
+          bool Flags = true>
+struct Transfer {
+  static void apply(CPU6502 &cpu) {
+    std::byte value = (cpu.*Get)();
+
+    (cpu.*Set)(value);
+
+    if constexpr (Flags) {
+      cpu.update_flags(value);
+    }
+  }
+};
+
+struct TAX : Transfer<&CPU6502::get_A, &CPU6502::set_X> {
+  static constexpr const char *NAME = "TAX";
+};
+
+struct TAY : Transfer<&CPU6502::get_A, &CPU6502::set_Y> {
+  static constexpr const char *NAME = "TAY";
+};
+
+struct TXA : Transfer<&CPU6502::get_X, &CPU6502::set_A> {
+  static constexpr const char *NAME = "TXA";
+};
+
+struct TYA : Transfer<&CPU6502::get_Y, &CPU6502::set_A> {
+  static constexpr const char *NAME = "TYA";
+};
+
+struct TSX : Transfer<&CPU6502::get_S, &CPU6502::set_X> {
+  static constexpr const char *NAME = "TSX";
+};
+
+struct TXS : Transfer<&CPU6502::get_X, &CPU6502::set_S, false> {
+  static constexpr const char *NAME = "TXS";
+};
+
+/// CLC, SEC, CLI, SEI, CLD, SED, CLV.
+template <psr_bit Flag, bool Value> struct SetFlag {
+  static void apply(CPU6502 &cpu) { cpu.get_PSR()->set_bit(Flag, Value); }
+};
+
+struct CLC : SetFlag<psr_bit::carry, false> {
+  static constexpr const char *NAME = "CLC";
+};
+
+struct SEC : SetFlag<psr_bit::carry, true> {
+  static constexpr const char *NAME = "SEC";
+};
+
+struct CLI : SetFlag<psr_bit::interrupt_disable, false> {
+  static constexpr const char *NAME = "CLI";
+};
+
+struct SEI : SetFlag<psr_bit::interrupt_disable, true> {
+  static constexpr const char *NAME = "SEI";
+};
+
+struct CLD : SetFlag<psr_bit::decimal_mode, false> {
+  static constexpr const char *NAME = "CLD";
+};
+
+struct SED : SetFlag<psr_bit::decimal_mode, true> {
+  static constexpr const char *NAME = "SED";
+};
+
+struct CLV : SetFlag<psr_bit::overflow, false> {
+  static constexpr const char *NAME = "CLV";
+};
+
+/// PHA, PHX, PHY.
+template <std::byte (CPU6502::*Register)() const> struct Push {
+  static void apply(CPU6502 &cpu) { cpu.push_stack((cpu.*Register)()); }
+};
+
+struct PHA : Push<&CPU6502::get_A> {
+  static constexpr const char *NAME = "PHA";
+};
+
+struct PHX : Push<&CPU6502::get_X> {
+  static constexpr const char *NAME = "PHX";
+};
+
+struct PHY : Push<&CPU6502::get_Y> {
+  static constexpr const char *NAME = "PHY";
+};
+
+/// PLA, PLX, PLY.
+template <void (CPU6502::*Register)(std::byte)> struct Pull {
+  static void apply(CPU6502 &cpu) {
+    std::byte value = cpu.pop_stack();
+
+    (cpu.*Register)(value);
+    cpu.update_flags(value);
+  }
+};
+
+struct PLA : Pull<&CPU6502::set_A> {
+  static constexpr const char *NAME = "PLA";
+};
+
+struct PLX : Pull<&CPU6502::set_X> {
+  static constexpr const char *NAME = "PLX";
+};
+
+struct PLY : Pull<&CPU6502::set_Y> {
+  static constexpr const char *NAME = "PLY";
+};
+
+struct PHP {
+  static constexpr const char *NAME = "PHP";
+
+  static void apply(CPU6502 &cpu) {
+    PSR psr = cpu.copy_PSR();
+    psr.set_bit(psr_bit::break_command, true);
+
+    cpu.push_stack(psr.get());
+  }
+};
+
+struct PLP {
+  static constexpr const char *NAME = "PLP";
+
+  static void apply(CPU6502 &cpu) { cpu.set_PSR(pull_status(cpu)); }
+};
+
+struct NOP {
+  static constexpr const char *NAME = "NOP";
+
+  static void apply(CPU6502 &) {}
+};
+
+} // namespace ops
+
+#endif
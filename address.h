@@ -56,6 +56,11 @@ constexpr bool operator==(const address &a, const size_t &b) noexcept {
   return a.inner() == b;
 }
 
+/// Do @p a and @p b lie in different 256-byte pages?
+constexpr bool crosses_page(const address &a, const address &b) noexcept {
+  return ((a.inner() ^ b.inner()) & 0xFF00) != 0;
+}
+
 struct address_result {
   address value;
   bool carry;
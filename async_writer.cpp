@@ -0,0 +1,124 @@
+#include "async_writer.h"
+#include "spsc_ring.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define ASYNC_WRITER_POSIX 1
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+/**
+ * Write all of @p data to @p fd. If the descriptor fails, the rest of the
+ * data is dropped, there is nobody left to read it.
+ */
+static void write_all(int fd, std::span<const char> data) {
+#ifdef ASYNC_WRITER_POSIX
+  while (!data.empty()) {
+    ssize_t written = ::write(fd, data.data(), data.size());
+
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      return;
+    }
+
+    data = data.subspan(static_cast<size_t>(written));
+  }
+#else
+  // without POSIX, everything goes to the standard output
+  (void)fd;
+
+  std::fwrite(data.data(), 1, data.size(), stdout);
+  std::fflush(stdout);
+#endif
+}
+
+AsyncWriter::AsyncWriter(int fd)
+    : fd_(fd), thread_([this]() { drain_ring(); }) {}
+
+AsyncWriter::~AsyncWriter() {
+  stop_.store(true, std::memory_order_release);
+  wake_up();
+
+  thread_.join();
+}
+
+void AsyncWriter::wake_up() {
+  wakeups_.fetch_add(1, std::memory_order_release);
+  wakeups_.notify_one();
+}
+
+/**
+ * The writer thread: write out whatever is in the ring, sleep while it is
+ * empty.
+ */
+void AsyncWriter::drain_ring() {
+  while (true) {
+    uint32_t wakeups = wakeups_.load(std::memory_order_acquire);
+    std::span<const char> chunk = ring_.peek();
+
+    if (chunk.empty()) {
+      // everything written before the stop is visible by now
+      if (stop_.load(std::memory_order_acquire) && ring_.peek().empty()) {
+        return;
+      }
+
+      // returns right away if the producer has been here since the load
+      wakeups_.wait(wakeups, std::memory_order_acquire);
+
+      continue;
+    }
+
+    write_all(fd_, chunk);
+
+    ring_.consume(chunk.size());
+    ring_.notify_producer();
+  }
+}
+
+void AsyncWriter::write(std::span<const char> data) {
+  bytes_ += data.size();
+
+  while (!data.empty()) {
+    data = data.subspan(ring_.push(data));
+
+    max_fill_ = std::max(max_fill_, ring_.size());
+    wake_up();
+
+    if (!data.empty()) {
+      // the ring is full, wait until the writer thread makes room
+      ++stalls_;
+
+      size_t head = ring_.head();
+
+      if (ring_.size() == ring_.capacity()) {
+        ring_.wait_for_consumer(head);
+      }
+    }
+  }
+}
+
+void AsyncWriter::drain() {
+  // everything handed over has been pushed, the writer is done once it has
+  // consumed as many bytes
+  while (true) {
+    size_t head = ring_.head();
+
+    if (head == bytes_) {
+      return;
+    }
+
+    ring_.wait_for_consumer(head);
+  }
+}
+
+void AsyncWriter::print_stats(std::ostream &stream) const {
+  stream << "Print device: " << bytes_ << " bytes written asynchronously, "
+         << stalls_ << " stalls on a full ring, at most " << max_fill_
+         << " of " << ring_.capacity() << " bytes in the ring" << std::endl;
+}
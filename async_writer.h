@@ -0,0 +1,70 @@
+#ifndef _H_ASYNC_WRITER
+#define _H_ASYNC_WRITER
+
+#include "spsc_ring.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <thread>
+
+/**
+ * Size of the ring between the emulation thread and the writer thread.
+ */
+constexpr size_t ASYNC_RING_SIZE = 64 * 1024;
+
+/**
+ * Writes output to a file descriptor on a thread of its own.
+ *
+ * The emulation thread hands bytes over through an @ref SpscRing and only
+ * waits when the ring is full, so a slow pipe downstream does not stall the
+ * CPU until the ring has filled up. How often that happened and how full the
+ * ring got is kept for @ref print_stats.
+ */
+class AsyncWriter {
+private:
+  SpscRing<ASYNC_RING_SIZE> ring_;
+
+  int fd_;
+
+  /// Bumped by the producer to wake the writer thread up.
+  std::atomic<uint32_t> wakeups_{0};
+  std::atomic<bool> stop_{false};
+
+  // statistics, only touched by the producer
+  uint64_t bytes_ = 0;
+  uint64_t stalls_ = 0;
+  size_t max_fill_ = 0;
+
+  std::thread thread_;
+
+  void wake_up();
+  void drain_ring();
+
+public:
+  /**
+   * Start the writer thread for @p fd, which has to stay open until the
+   * writer is destroyed.
+   */
+  explicit AsyncWriter(int fd);
+
+  /// Write out everything in the ring and stop the writer thread.
+  ~AsyncWriter();
+
+  AsyncWriter(const AsyncWriter &) = delete;
+  AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+  /**
+   * Hand @p data over to the writer thread. Only blocks if the ring is full.
+   */
+  void write(std::span<const char> data);
+
+  /// Block until the writer thread has written everything handed over.
+  void drain();
+
+  void print_stats(std::ostream &stream) const;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "../6502cpu.h"
+#include "../block_cache.h"
+#include "../bus.h"
+#include "../gp_memory.h"
+#include "../jit.h"
+#include "../instruction_types.h"
+#include "../mapped_image.h"
+#include "../print_device.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+/**
+ * Upper bound of instructions counted in one run, programs which do not stop
+ * by then are rejected.
+ */
+constexpr uint64_t MAX_INSTRUCTIONS = 500'000'000;
+
+/**
+ * Count the instructions the program in @p image executes until it stops, by
+ * stepping a fresh CPU.
+ *
+ * @return The number of instructions, or `MAX_INSTRUCTIONS` if the program
+ * did not stop.
+ */
+static uint64_t count_instructions(MappedImage &image) {
+  Bus bus(image.data());
+  PrintDevice print_device(std::cout);
+  bus.map_device(address(DEFAULT_OUTPUT_ADDRESS),
+                 address(DEFAULT_OUTPUT_ADDRESS), &print_device);
+  CPU6502 cpu(&bus);
+
+  RunResult result = cpu.run(RunBudget{.instructions = MAX_INSTRUCTIONS});
+
+  return result.instructions;
+}
+
+/**
+ * Run the program in @p file on a fresh CPU until it stops.
+ *
+ * @param file The image to run, mapped again for every run.
+ * @param core The execution core to run the program on.
+ * @return The time it took, without loading the image.
+ */
+static double run_once(const std::string &file, ExecutionCore core) {
+  MappedImage image(file);
+  Bus bus(image.data());
+  PrintDevice print_device(std::cout);
+  bus.map_device(address(DEFAULT_OUTPUT_ADDRESS),
+                 address(DEFAULT_OUTPUT_ADDRESS), &print_device);
+  BlockCache block_cache(&bus);
+  Jit jit;
+  CPU6502 cpu(&bus);
+  cpu.set_core(core);
+  cpu.set_block_cache(&block_cache);
+  cpu.set_jit(&jit);
+
+  auto start = std::chrono::steady_clock::now();
+
+  cpu.run();
+
+  auto end = std::chrono::steady_clock::now();
+
+  return std::chrono::duration<double>(end - start).count();
+}
+
+int main(int argc, char **argv) {
+  int iterations = 5;
+  ExecutionCore core = ExecutionCore::Stepper;
+  std::vector<std::string> files;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+      iterations = std::stoi(argv[++i]);
+    } else if (strcmp(argv[i], "--core") == 0 && i + 1 < argc) {
+      auto parsed = parse_execution_core(argv[++i]);
+
+      if (!parsed) {
+        std::cerr << "Unknown core: " << argv[i] << std::endl;
+
+        return 1;
+      }
+
+      core = *parsed;
+    } else {
+      files.emplace_back(argv[i]);
+    }
+  }
+
+  if (files.empty() || iterations <= 0) {
+    std::cout << "Usage: " << argv[0]
+              << " [-n ITERATIONS] [--core stepper|threaded|cached|jit] "
+                 "<path to binary file>...\n";
+
+    return 1;
+  }
+
+  for (const auto &file : files) {
+    std::optional<MappedImage> image;
+
+    auto load_start = std::chrono::steady_clock::now();
+
+    try {
+      image.emplace(file);
+    } catch (std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+
+      return 1;
+    }
+
+    std::chrono::duration<double, std::micro> load_time =
+        std::chrono::steady_clock::now() - load_start;
+
+    // the guest output (print device, warnings) would only skew the numbers
+    std::streambuf *cout_buf = std::cout.rdbuf(nullptr);
+
+    uint64_t instructions = count_instructions(*image);
+
+    if (instructions >= MAX_INSTRUCTIONS) {
+      std::cout.rdbuf(cout_buf);
+      std::cout.clear();
+      std::cerr << file << ": does not stop within " << MAX_INSTRUCTIONS
+                << " instructions" << std::endl;
+
+      return 1;
+    }
+
+    double seconds = 0;
+
+    for (int i = 0; i < iterations; ++i) {
+      seconds += run_once(file, core);
+    }
+
+    std::cout.rdbuf(cout_buf);
+    std::cout.clear();
+
+    std::cout << file << ": " << instructions << " instructions/run, "
+              << std::fixed << std::setprecision(2)
+              << static_cast<double>(instructions) * iterations / seconds / 1e6
+              << " M instructions/s, loaded in " << load_time.count() << " us"
+              << std::endl;
+  }
+
+  return 0;
+}
@@ -0,0 +1,230 @@
+#include "binary_trace.h"
+#include "6502cpu.h"
+#include "address.h"
+#include "hooks.h"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iomanip>
+#include <ios>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BINARY_TRACE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+BinaryTrace::BinaryTrace(const std::string &filename, uint64_t capacity)
+    : filename_(filename) {
+  if (capacity == 0) {
+    throw std::invalid_argument("The trace needs room for a record.");
+  }
+
+  size_ = sizeof(TraceHeader) + capacity * sizeof(TraceRecord);
+
+#ifdef BINARY_TRACE_MMAP
+  int fd = open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0) {
+    throw std::runtime_error(
+        std::format("Could not create trace file {}.", filename));
+  }
+
+  void *base = MAP_FAILED;
+
+  if (ftruncate(fd, static_cast<off_t>(size_)) == 0) {
+    base = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  }
+
+  close(fd);
+
+  if (base == MAP_FAILED) {
+    throw std::runtime_error(
+        std::format("Could not map trace file {}.", filename));
+  }
+
+  data_ = static_cast<std::byte *>(base);
+#else
+  data_ = new std::byte[size_]();
+#endif
+
+  header_ = new (data_) TraceHeader();
+  std::memcpy(header_->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+  header_->version = TRACE_VERSION;
+  header_->record_size = sizeof(TraceRecord);
+  header_->capacity = capacity;
+
+  records_ = reinterpret_cast<TraceRecord *>(data_ + sizeof(TraceHeader));
+}
+
+BinaryTrace::~BinaryTrace() {
+#ifdef BINARY_TRACE_MMAP
+  munmap(data_, size_);
+#else
+  std::ofstream file(filename_, std::ios::binary);
+
+  file.write(reinterpret_cast<const char *>(data_),
+             static_cast<std::streamsize>(size_));
+
+  delete[] data_;
+#endif
+}
+
+/// A record of the registers of @p cpu.
+static TraceRecord registers_of(const CPU6502 &cpu, TraceKind kind) {
+  TraceRecord record;
+
+  record.cycle = static_cast<uint32_t>(cpu.get_cycles());
+  record.addr = cpu.get_PC().inner();
+  record.kind = kind;
+  record.a = std::to_integer<uint8_t>(cpu.get_A());
+  record.x = std::to_integer<uint8_t>(cpu.get_X());
+  record.y = std::to_integer<uint8_t>(cpu.get_Y());
+  record.s = std::to_integer<uint8_t>(cpu.get_S());
+  record.p = std::to_integer<uint8_t>(cpu.get_PSR()->get());
+
+  return record;
+}
+
+void BinaryTrace::before_instruction(const CPU6502 &cpu, std::byte opcode) {
+  TraceRecord record = registers_of(cpu, TraceKind::Instruction);
+  record.value = std::to_integer<uint8_t>(opcode);
+
+  cycle_ = record.cycle;
+  append(record);
+}
+
+void BinaryTrace::memory_read(address addr, std::byte value) {
+  TraceRecord record;
+  record.cycle = cycle_;
+  record.addr = addr.inner();
+  record.kind = TraceKind::Read;
+  record.value = std::to_integer<uint8_t>(value);
+
+  append(record);
+}
+
+void BinaryTrace::memory_write(address addr, std::byte value) {
+  TraceRecord record;
+  record.cycle = cycle_;
+  record.addr = addr.inner();
+  record.kind = TraceKind::Write;
+  record.value = std::to_integer<uint8_t>(value);
+
+  append(record);
+}
+
+void BinaryTrace::interrupt_entry(const CPU6502 &cpu, address vector) {
+  TraceRecord record = registers_of(cpu, TraceKind::Interrupt);
+  record.vector = std::to_integer<uint8_t>(vector.low());
+
+  cycle_ = record.cycle;
+  append(record);
+}
+
+/**
+ * Print the registers of an instruction or interrupt record. Leaves the
+ * format of the stream as it was, the instructions are printed with it.
+ */
+static void print_registers(std::ostream &stream, const TraceRecord &record) {
+  std::ios_base::fmtflags flags = stream.flags();
+  char fill = stream.fill('0');
+
+  stream << std::hex << "  A: " << std::setw(2) << static_cast<int>(record.a)
+         << " X: " << std::setw(2) << static_cast<int>(record.x)
+         << " Y: " << std::setw(2) << static_cast<int>(record.y)
+         << " S: " << std::setw(2) << static_cast<int>(record.s)
+         << " P: " << std::setw(2) << static_cast<int>(record.p)
+         << " cycle: " << std::dec << record.cycle << std::endl;
+
+  stream.flags(flags);
+  stream.fill(fill);
+}
+
+/// Print a read or write record, like @ref print_registers.
+static void print_access(std::ostream &stream, const TraceRecord &record) {
+  std::ios_base::fmtflags flags = stream.flags();
+  char fill = stream.fill('0');
+
+  stream << (record.kind == TraceKind::Read ? "  READ " : "  WRITE ")
+         << std::hex << std::setw(4) << record.addr << ": " << std::setw(2)
+         << static_cast<int>(record.value) << std::endl;
+
+  stream.flags(flags);
+  stream.fill(fill);
+}
+
+uint64_t decode_trace(const std::string &filename, std::ostream &stream,
+                      bool effects) {
+  std::ifstream file(filename, std::ios::binary);
+
+  if (!file.good()) {
+    throw std::runtime_error(
+        std::format("Could not open trace file {}.", filename));
+  }
+
+  TraceHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+  if (!file.good() ||
+      std::memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+      header.version != TRACE_VERSION ||
+      header.record_size != sizeof(TraceRecord) || header.capacity == 0) {
+    throw std::runtime_error(
+        std::format("{} is not a trace file of this version.", filename));
+  }
+
+  std::vector<TraceRecord> records(header.capacity);
+  file.read(reinterpret_cast<char *>(records.data()),
+            static_cast<std::streamsize>(records.size() *
+                                         sizeof(TraceRecord)));
+
+  if (!file.good()) {
+    throw std::runtime_error(
+        std::format("The trace file {} is truncated.", filename));
+  }
+
+  uint64_t count = std::min(header.written, header.capacity);
+  uint64_t first = header.written > header.capacity
+                       ? header.written % header.capacity
+                       : 0;
+
+  for (uint64_t i = 0; i < count; ++i) {
+    const TraceRecord &record = records[(first + i) % header.capacity];
+
+    switch (record.kind) {
+    case TraceKind::Instruction:
+      print_instruction(stream, std::byte(record.value),
+                        address(record.addr));
+
+      if (effects) {
+        print_registers(stream, record);
+      }
+      break;
+    case TraceKind::Interrupt:
+      print_interrupt(stream,
+                      address(std::byte(record.vector), std::byte{0xFF}));
+
+      if (effects) {
+        print_registers(stream, record);
+      }
+      break;
+    case TraceKind::Read:
+    case TraceKind::Write:
+      if (effects) {
+        print_access(stream, record);
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  return header.written - count;
+}
@@ -0,0 +1,143 @@
+#ifndef _H_BINARY_TRACE
+#define _H_BINARY_TRACE
+
+#include "address.h"
+#include "hooks.h"
+#include "instruction_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+/// Marks a file as a binary trace, see @ref TraceHeader.
+constexpr char TRACE_MAGIC[8] = {'6', '5', '0', '2', 'T', 'R', 'C', '\0'};
+constexpr uint32_t TRACE_VERSION = 1;
+
+/// Records a trace file keeps by default, see @ref BinaryTrace.
+constexpr uint64_t DEFAULT_TRACE_RECORDS = 1'000'000;
+
+/// What a @ref TraceRecord records.
+enum class TraceKind : uint8_t {
+  /// An instruction about to run, with the registers before it.
+  Instruction,
+  /// An IRQ or NMI taken.
+  Interrupt,
+  /// A read of data by the instruction or interrupt before.
+  Read,
+  /// A write by the instruction or interrupt before.
+  Write
+};
+
+/**
+ * One entry of a binary trace. The memory effects of an instruction or an
+ * interrupt follow it as records of their own, so every record has the same
+ * size.
+ */
+struct TraceRecord {
+  /// The low 32 bits of the cycle of the instruction (see
+  /// @ref CPU6502::get_cycles), before its cycles were counted.
+  uint32_t cycle = 0;
+  /// The program counter of an instruction or interrupt, or the address of a
+  /// read or write.
+  uint16_t addr = 0;
+  TraceKind kind = TraceKind::Instruction;
+  /// The opcode of an instruction, or the value read or written.
+  uint8_t value = 0;
+  /// The registers before an instruction or interrupt, zero for reads and
+  /// writes.
+  uint8_t a = 0, x = 0, y = 0, s = 0, p = 0;
+  /// The low byte of the vector of an interrupt.
+  uint8_t vector = 0;
+  uint8_t reserved[2] = {};
+};
+
+static_assert(sizeof(TraceRecord) == 16);
+
+/**
+ * The start of a trace file, followed by @ref capacity records. The records
+ * form a ring: the oldest one is at `written % capacity` once the ring is
+ * full. All fields are in host byte order.
+ */
+struct TraceHeader {
+  char magic[8] = {};
+  uint32_t version = 0;
+  uint32_t record_size = 0;
+  uint64_t capacity = 0;
+  /// The records written since the trace started, including overwritten
+  /// ones.
+  uint64_t written = 0;
+};
+
+/**
+ * Records a run into a file of fixed-size @ref TraceRecord "records",
+ * keeping only the last ones (see @ref CPU6502::set_hooks).
+ *
+ * The file is mapped into memory, so a record costs a copy and nothing is
+ * formatted while the program runs; the header is kept up to date after
+ * every record, so even the trace of a crashed run can be decoded (see
+ * @ref decode_trace).
+ *
+ * On hosts without `mmap` the ring is kept in memory and written to the file
+ * when the trace is destroyed.
+ */
+class BinaryTrace : public ExecutionHooks {
+private:
+  std::string filename_;
+  std::byte *data_ = nullptr;
+  size_t size_ = 0;
+
+  TraceHeader *header_ = nullptr;
+  TraceRecord *records_ = nullptr;
+  /// Where the next record goes.
+  uint64_t next_ = 0;
+  /// The cycle of the last instruction or interrupt, for its memory effects.
+  uint32_t cycle_ = 0;
+
+  void append(const TraceRecord &record) {
+    records_[next_] = record;
+
+    if (++next_ == header_->capacity) {
+      next_ = 0;
+    }
+
+    ++header_->written;
+  }
+
+public:
+  /**
+   * Create the trace file @p filename, replacing an existing one, with room
+   * for @p capacity records.
+   *
+   * @throws std::invalid_argument If the capacity is zero.
+   * @throws std::runtime_error If the file could not be created or mapped.
+   */
+  BinaryTrace(const std::string &filename, uint64_t capacity);
+  ~BinaryTrace();
+
+  BinaryTrace(const BinaryTrace &) = delete;
+  BinaryTrace &operator=(const BinaryTrace &) = delete;
+
+  void before_instruction(const CPU6502 &cpu, std::byte opcode) override;
+  void memory_read(address addr, std::byte value) override;
+  void memory_write(address addr, std::byte value) override;
+  void interrupt_entry(const CPU6502 &cpu, address vector) override;
+
+  /// The records written so far, including overwritten ones.
+  uint64_t written() const { return header_->written; }
+};
+
+/**
+ * Print the trace in the file @p filename, oldest record first, in the
+ * format of verbose mode (see @ref TraceHooks).
+ *
+ * @param effects Also print the registers before every instruction and the
+ * reads and writes.
+ * @return The number of older records the ring overwrote.
+ * @throws std::runtime_error If the file could not be read or is not a
+ * trace.
+ */
+uint64_t decode_trace(const std::string &filename, std::ostream &stream,
+                      bool effects);
+
+#endif
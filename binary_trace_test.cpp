@@ -0,0 +1,197 @@
+#include "binary_trace.h"
+#include "6502cpu.h"
+#include "hooks.h"
+#include "interrupt_controller.h"
+#include "scheduler.h"
+#include "unit_test.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/// The cycles the program runs for.
+constexpr uint64_t RUN_CYCLES = 6000;
+/// An NMI is raised every this many cycles.
+constexpr uint64_t NMI_PERIOD = 97;
+
+/// Records of the smallest trace that has to wrap around.
+constexpr uint64_t SMALL_CAPACITY = 301;
+
+/**
+ * Run a loop storing to memory, interrupted by NMIs whose handler counts
+ * them, with @p hooks set:
+ *
+ *     0200  LDX #$00
+ *     0202  TXA
+ *     0203  STA $0300,X
+ *     0206  INX
+ *     0207  BNE $0202
+ *     0209  JMP $0200
+ *
+ *     0500  INC $20
+ *     0502  RTI
+ */
+static void run_program(ExecutionHooks &hooks) {
+  ScheduledMachine machine;
+  machine.load(TEST_CODE, {0xA2, 0x00, 0x8A, 0x9D, 0x00, 0x03, 0xE8, 0xD0,
+                           0xF9, 0x4C, 0x00, 0x02});
+  machine.load(0x0500, {0xE6, 0x20, 0x40});
+  machine.load(NMI_VECTOR, {0x00, 0x05});
+
+  InterruptController interrupts;
+  Scheduler &scheduler = machine.scheduler;
+
+  machine.cpu.set_interrupts(&interrupts);
+  machine.cpu.set_hooks(&hooks);
+
+  std::function<void(uint64_t)> nmi = [&](uint64_t due) {
+    interrupts.raise_nmi();
+    scheduler.schedule(due + NMI_PERIOD, nmi);
+  };
+
+  scheduler.schedule(NMI_PERIOD, nmi);
+
+  machine.cpu.run_for_cycles(RUN_CYCLES);
+}
+
+/// Record a trace of the program into @p filename.
+static uint64_t record_trace(const std::string &filename, uint64_t capacity) {
+  BinaryTrace trace(filename, capacity);
+
+  run_program(trace);
+
+  return trace.written();
+}
+
+/// The records of the trace in @p filename, in the order of the file.
+static std::vector<TraceRecord> read_records(const std::string &filename) {
+  std::ifstream file(filename, std::ios::binary);
+  TraceHeader header;
+  file.read(reinterpret_cast<char *>(&header), sizeof(header));
+
+  std::vector<TraceRecord> records(header.capacity);
+  file.read(reinterpret_cast<char *>(records.data()),
+            static_cast<std::streamsize>(records.size() * sizeof(TraceRecord)));
+
+  return records;
+}
+
+/// Split verbose output into its instructions and interrupts.
+static std::vector<std::string> split_entries(const std::string &output) {
+  std::vector<std::string> entries;
+  std::istringstream stream(output);
+  std::string line;
+
+  while (std::getline(stream, line)) {
+    if (line.starts_with("INSTRUCTION:") || line.starts_with("INTERRUPT:")) {
+      entries.emplace_back();
+    }
+
+    if (!check(!entries.empty(), "verbose output starts with " + line)) {
+      break;
+    }
+
+    entries.back() += line + "\n";
+  }
+
+  return entries;
+}
+
+/**
+ * Record a trace of @p capacity records into @p filename, which wraps around,
+ * and check that it decodes to the last of the verbose @p entries.
+ *
+ * @param written The records of the whole run.
+ */
+static void check_wrapped(const std::string &filename, uint64_t capacity,
+                          uint64_t written,
+                          const std::vector<std::string> &entries) {
+  uint64_t wrapped_written = record_trace(filename, capacity);
+
+  check(wrapped_written == written,
+        std::format("{} records in the wrapped trace, {} in the full one",
+                    wrapped_written, written));
+
+  std::ostringstream decoded;
+  uint64_t lost = decode_trace(filename, decoded, false);
+
+  check(lost == written - capacity,
+        std::format("{} records reported lost, {} expected", lost,
+                    written - capacity));
+
+  size_t kept = 0;
+
+  for (const TraceRecord &record : read_records(filename)) {
+    if (record.kind == TraceKind::Instruction ||
+        record.kind == TraceKind::Interrupt) {
+      ++kept;
+    }
+  }
+
+  std::string expected;
+
+  for (size_t i = entries.size() - std::min(kept, entries.size());
+       i < entries.size(); ++i) {
+    expected += entries[i];
+  }
+
+  check(kept > 0 && kept < entries.size(),
+        std::format("{} of {} entries kept by the wrapped trace", kept,
+                    entries.size()));
+  check(decoded.str() == expected,
+        std::format("the trace of {} records is not the end of verbose output",
+                    capacity));
+}
+
+int main() {
+  std::ostringstream verbose;
+  TraceHooks trace_hooks(verbose);
+  run_program(trace_hooks);
+
+  std::vector<std::string> entries = split_entries(verbose.str());
+
+  // printing an instruction leaves the stream printing numbers in decimal
+  std::ostringstream twice;
+  print_instruction(twice, std::byte(NOP), address(TEST_CODE));
+  print_instruction(twice, std::byte(NOP), address(TEST_CODE));
+  check(twice.str() == "INSTRUCTION: NOP (234)\n  PC: 200\n"
+                       "INSTRUCTION: NOP (234)\n  PC: 200\n",
+        std::format("printing instructions changed the number format:\n{}",
+                    twice.str()));
+  check(verbose.str().find("INTERRUPT: NMI") != std::string::npos,
+        "the program took no NMI");
+
+  std::filesystem::path directory = std::filesystem::temp_directory_path();
+  std::string full = (directory / "binary_trace_test_full.trc").string();
+  std::string wrapped = (directory / "binary_trace_test_wrapped.trc").string();
+
+  // the whole run fits: the decoded trace is the verbose output
+  uint64_t written = record_trace(full, uint64_t(1) << 16);
+
+  std::ostringstream decoded;
+  uint64_t overwritten = decode_trace(full, decoded, false);
+
+  check(overwritten == 0, "the full trace lost records");
+  check(decoded.str() == verbose.str(),
+        "the decoded trace differs from verbose output");
+
+  // the ring wraps: the decoded trace is the end of the verbose output, one
+  // entry for every instruction and interrupt record left in the ring, with
+  // the ring starting at records of every kind
+  for (uint64_t capacity = SMALL_CAPACITY; capacity < SMALL_CAPACITY + 16;
+       ++capacity) {
+    check_wrapped(wrapped, capacity, written, entries);
+  }
+
+  std::filesystem::remove(full);
+  std::filesystem::remove(wrapped);
+
+  return finish_checks("binary_trace");
+}
@@ -0,0 +1,201 @@
+#include "block_cache.h"
+#include "6502cpu.h"
+#include "6502isa.h"
+#include "address.h"
+#include "bus.h"
+#include "fusion.h"
+#include "gp_memory.h"
+#include "instruction_types.h"
+
+#include <array>
+#include <cstddef>
+#include <utility>
+
+/**
+ * Does the instruction always continue somewhere else than at the following
+ * address (or stop the CPU)?
+ */
+static bool ends_block(const Instruction &instruction) {
+  switch (instruction.mnemonic) {
+  case mnemonic_index("BRA"):
+  case mnemonic_index("BRK"):
+  case mnemonic_index("DBG"):
+  case mnemonic_index("JMP"):
+  case mnemonic_index("JSR"):
+  case mnemonic_index("RTI"):
+  case mnemonic_index("RTS"):
+  case mnemonic_index("STP"):
+  case mnemonic_index("WAI"):
+    return true;
+  default:
+    return false;
+  }
+}
+
+/// Runs a decoded instruction with the handler of its opcode.
+template <size_t Opcode>
+static InstructionErr run_decoded(CPU6502 &cpu,
+                                  const DecodedInstruction &instruction) {
+  constexpr Instruction isa_instruction = isa[Opcode];
+
+  if constexpr (isa_instruction.valid()) {
+    return isa_instruction.execute(cpu, instruction.operand);
+  } else {
+    // unknown opcodes are never decoded
+    return InstructionErr::UnknownInstruction;
+  }
+}
+
+template <size_t... Opcodes>
+static constexpr std::array<DecodedHandler, 256>
+make_decoded_handlers(std::index_sequence<Opcodes...>) {
+  return {run_decoded<Opcodes>...};
+}
+
+/// The handlers of decoded instructions, indexed by opcode.
+static constexpr std::array<DecodedHandler, 256> DECODED_HANDLERS =
+    make_decoded_handlers(std::make_index_sequence<256>());
+
+/**
+ * Where does the instruction at @p pc go when it jumps or takes its branch?
+ * Only for instructions that @ref may_jump_to_itself.
+ */
+static address jump_target(const Instruction &instruction, size_t pc,
+                           address operand) {
+  switch (instruction.mode) {
+  case AddressingMode::PCRelative:
+    return address(static_cast<int>(pc) + 2 +
+                   static_cast<int8_t>(operand.low()));
+  case AddressingMode::ZeroPageRelative:
+    return address(static_cast<int>(pc) + 3 +
+                   static_cast<int8_t>(operand.high()));
+  default:
+    return operand;
+  }
+}
+
+/**
+ * Does the instruction read a device? Only for instructions that are
+ * @ref is_side_effect_free, which read their operand address if anything.
+ */
+static bool reads_device(const Bus &bus, const Instruction &instruction,
+                         address operand) {
+  switch (instruction.mode) {
+  case AddressingMode::ZeroPage:
+  case AddressingMode::ZeroPageRelative:
+    return bus.has_device(0);
+  case AddressingMode::Absolute:
+    return instruction.mnemonic != mnemonic_index("JMP") &&
+           bus.has_device(page_of(operand));
+  default:
+    return false;
+  }
+}
+
+BlockCache::BlockCache(Bus *bus) : bus_(bus), blocks_(MEMORY_SIZE) {
+  if (bus_ == nullptr) {
+    throw CPUException("Bus cannot be null.");
+  }
+}
+
+/**
+ * Decode the block at @p pc into its slot, reusing the previous block there.
+ */
+DecodedBlock *BlockCache::refill(address pc) {
+  std::unique_ptr<DecodedBlock> &slot = blocks_[pc.inner()];
+
+  if (slot == nullptr) {
+    slot = std::make_unique<DecodedBlock>();
+  }
+
+  decode(pc, *slot);
+
+  return slot.get();
+}
+
+/**
+ * Decode instructions from @p start until the end of the block.
+ */
+void BlockCache::decode(address start, DecodedBlock &block) {
+  block.instructions.clear();
+  block.fused.clear();
+  block.idle_length = 0;
+  block.executions = 0;
+  block.native = nullptr;
+
+  size_t page = page_of(start);
+  size_t pc = start.inner();
+  size_t end = pc;
+
+  // are the instructions so far free of side effects, see idle_length
+  bool idle = true;
+
+  while (pc / PAGE_SIZE == page && !bus_->has_device(page)) {
+    std::byte opcode = bus_->fetch(pc);
+    const Instruction &instruction = isa[std::to_integer<size_t>(opcode)];
+
+    // unknown opcodes and instructions that wrap around the address space or
+    // reach into a device are left to the stepper
+    if (!instruction.valid() || pc + instruction.bytes > MEMORY_SIZE ||
+        bus_->has_device((pc + instruction.bytes - 1) / PAGE_SIZE)) {
+      break;
+    }
+
+    DecodedInstruction decoded;
+    decoded.execute = DECODED_HANDLERS[std::to_integer<size_t>(opcode)];
+    decoded.opcode = std::to_integer<uint8_t>(opcode);
+    decoded.bytes = instruction.bytes;
+    decoded.cycles = instruction.cycles;
+
+    if (instruction.bytes == 2) {
+      decoded.operand = address(bus_->fetch(pc + 1));
+    } else if (instruction.bytes == 3) {
+      decoded.operand = address(bus_->fetch(pc + 1), bus_->fetch(pc + 2));
+    }
+
+    block.instructions.push_back(decoded);
+
+    if (idle && block.idle_length == 0) {
+      idle = is_side_effect_free(instruction) &&
+             !reads_device(*bus_, instruction, decoded.operand);
+
+      if (idle && may_jump_to_itself(instruction) &&
+          jump_target(instruction, pc, decoded.operand) == start) {
+        block.idle_length = static_cast<uint16_t>(block.instructions.size());
+      }
+    }
+
+    pc += instruction.bytes;
+    end = pc;
+
+    if (ends_block(instruction)) {
+      break;
+    }
+  }
+
+  fuse_idioms(block.instructions, block.fused, count_fusions_);
+
+  // the operand of the last instruction can reach into the next page
+  block.first_page = page;
+  block.last_page = end > start.inner() ? page_of(address(end - 1)) : page;
+  block.first_version = bus_->page_version(block.first_page);
+  block.last_version = bus_->page_version(block.last_page);
+
+  bus_->mark_code_page(block.first_page);
+  bus_->mark_code_page(block.last_page);
+}
+
+void BlockCache::clear() {
+  for (std::unique_ptr<DecodedBlock> &block : blocks_) {
+    block.reset();
+  }
+}
+
+void BlockCache::drop_native() {
+  for (std::unique_ptr<DecodedBlock> &block : blocks_) {
+    if (block != nullptr) {
+      block->executions = 0;
+      block->native = nullptr;
+    }
+  }
+}
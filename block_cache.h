@@ -0,0 +1,151 @@
+#ifndef _H_BLOCK_CACHE
+#define _H_BLOCK_CACHE
+
+#include "address.h"
+#include "bus.h"
+#include "gp_memory.h"
+#include "instruction_types.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class CPU6502;
+
+/**
+ * Entry point of a block compiled to host code (see @ref Jit). Gets the CPU,
+ * the contents of the RAM, the bus and its code version (see
+ * @ref Bus::code_version).
+ */
+using NativeBlock = InstructionErr (*)(CPU6502 *, std::byte *, Bus *,
+                                       const uint64_t *);
+
+struct DecodedInstruction;
+
+/**
+ * Runs a @ref DecodedInstruction. Gets the instruction itself, so that a fused
+ * idiom finds the operands of all its instructions.
+ */
+using DecodedHandler = InstructionErr (*)(CPU6502 &,
+                                          const DecodedInstruction &);
+
+/**
+ * One instruction decoded ahead of its execution.
+ */
+struct DecodedInstruction {
+  /// Runs the handler of the opcode, or of the idiom that starts with it (see
+  /// @ref DecodedBlock::fused).
+  DecodedHandler execute = nullptr;
+  /// The raw operand, as @ref CPU6502::fetch_operand would read it.
+  address operand{};
+  /// The operand bytes of the following instructions of a fused idiom.
+  address fused_operands{};
+  uint8_t opcode = 0;
+  /// The length of the instruction in bytes.
+  uint8_t bytes = 0;
+  /// The base number of cycles of the instruction.
+  uint8_t cycles = 0;
+};
+
+/**
+ * A run of instructions decoded from consecutive addresses.
+ *
+ * A block ends after an instruction that always transfers control (jumps,
+ * returns, BRK, STP, ...), before an unknown opcode or an instruction that
+ * wraps around the address space or reaches a page with a device, or when the
+ * next instruction would start on another page. Conditional
+ * branches stay inside the block: a taken branch simply leaves it.
+ *
+ * A block that starts with a loop of instructions that only read RAM and
+ * change registers (see @ref is_side_effect_free) may be an idle loop, the
+ * CPU then skips ahead instead of running it over and over.
+ */
+struct DecodedBlock {
+  std::vector<DecodedInstruction> instructions;
+  /// The instructions the interpreter runs, with common idioms fused into
+  /// one handler (see @ref fuse_idioms).
+  std::vector<DecodedInstruction> fused;
+
+  /// The page of the first instruction and the page of the last byte.
+  size_t first_page = 0, last_page = 0;
+  /// The versions of those pages at decode time.
+  uint32_t first_version = 0, last_version = 0;
+
+  /// The instructions of the idle loop the block starts with, if it starts
+  /// with one (see @ref CPU6502::run_idle_loop), otherwise 0.
+  uint16_t idle_length = 0;
+
+  /// How many times the block was entered, used to find hot blocks.
+  uint32_t executions = 0;
+  /// The block compiled to host code (see @ref Jit), if it was.
+  NativeBlock native = nullptr;
+
+  /// Is the block still what the memory holds?
+  bool valid(const Bus &bus) const {
+    return bus.page_version(first_page) == first_version &&
+           bus.page_version(last_page) == last_version;
+  }
+};
+
+/**
+ * Cache of @ref DecodedBlock "decoded blocks", keyed by the address of their
+ * first instruction.
+ *
+ * Pages blocks are decoded from are marked on the bus (see
+ * @ref Bus::mark_code_page), so a write to a page with cached code
+ * invalidates all blocks decoded from it and they are decoded again on their
+ * next lookup. Code on pages with a device is never decoded, reading it could
+ * have side effects.
+ */
+class BlockCache {
+private:
+  Bus *bus_;
+
+  std::vector<std::unique_ptr<DecodedBlock>> blocks_;
+
+  bool count_fusions_ = false;
+
+  void decode(address start, DecodedBlock &block);
+  DecodedBlock *refill(address pc);
+
+public:
+  /**
+   * Create an empty cache for the code on @p bus.
+   *
+   * @throws CPUException If the bus is null.
+   */
+  explicit BlockCache(Bus *bus);
+
+  /**
+   * Find the block starting at @p pc, decoding it if it is not cached or the
+   * memory it was decoded from has been written to since.
+   *
+   * @return The block, or `nullptr` if not even one instruction can be
+   * decoded at @p pc.
+   */
+  DecodedBlock *lookup(address pc) {
+    DecodedBlock *block = blocks_[pc.inner()].get();
+
+    if (block == nullptr || !block->valid(*bus_)) {
+      block = refill(pc);
+    }
+
+    return block->instructions.empty() ? nullptr : block;
+  }
+
+  /**
+   * Count how often each fused idiom runs (see @ref print_fusion_stats), in
+   * blocks decoded from now on.
+   */
+  void set_count_fusions(bool value) { count_fusions_ = value; };
+
+  /// Drop all decoded blocks.
+  void clear();
+
+  /// Forget the host code of all blocks, they are interpreted again.
+  void drop_native();
+};
+
+#endif
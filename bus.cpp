@@ -0,0 +1,201 @@
+#include "bus.h"
+#include "6502cpu.h"
+#include "address.h"
+#include "device.h"
+#include "gp_memory.h"
+
+Bus::Bus(std::byte *ram) : ram_(ram) {
+  if (ram_ == nullptr) {
+    throw CPUException("Memory cannot be null.");
+  }
+
+  map_ram(0, PAGE_COUNT, ram_);
+}
+
+Bus::Bus(GP_Memory *ram) : Bus(ram != nullptr ? ram->data() : nullptr) {}
+
+/**
+ * Point the fast paths of a page at its storage, unless the page needs the
+ * slow path.
+ */
+void Bus::update_pointers(size_t page) {
+  const Page &entry = pages_[page];
+
+  if (hooks_ != nullptr) {
+    read_pages_[page] = nullptr;
+    write_pages_[page] = nullptr;
+
+    return;
+  }
+
+  read_pages_[page] = entry.device ? nullptr : entry.storage;
+  write_pages_[page] =
+      entry.writable && !entry.device && !entry.code ? entry.storage : nullptr;
+}
+
+/**
+ * Invalidate the code decoded from a page, see @ref mark_code_page.
+ */
+void Bus::invalidate_code(size_t page) {
+  if (pages_[page].code) {
+    pages_[page].code = false;
+    ++page_versions_[page];
+    ++code_version_;
+
+    update_pointers(page);
+  }
+}
+
+void Bus::map_storage(size_t first_page, size_t pages, std::byte *storage,
+                      bool writable) {
+  for (size_t i = 0; i < pages && first_page + i < PAGE_COUNT; ++i) {
+    Page &entry = pages_[first_page + i];
+
+    // the code decoded from the page came from the previous storage
+    invalidate_code(first_page + i);
+
+    entry.storage = storage + i * PAGE_SIZE;
+    entry.writable = writable;
+
+    update_pointers(first_page + i);
+  }
+}
+
+void Bus::map_ram(size_t first_page, size_t pages, std::byte *storage) {
+  map_storage(first_page, pages, storage, true);
+}
+
+void Bus::map_rom(size_t first_page, size_t pages, const std::byte *storage) {
+  // never written through, see update_pointers
+  map_storage(first_page, pages, const_cast<std::byte *>(storage), false);
+}
+
+void Bus::map_device(address first, address last, Device *device) {
+  if (device == nullptr) {
+    throw CPUException("Device cannot be null.");
+  }
+
+  if (first.inner() > last.inner()) {
+    throw CPUException("The device range is empty.");
+  }
+
+  devices_.push_back({first, last, device});
+
+  for (size_t page = page_of(first); page <= page_of(last); ++page) {
+    invalidate_code(page);
+
+    pages_[page].device = true;
+
+    update_pointers(page);
+  }
+}
+
+void Bus::set_hooks(ExecutionHooks *hooks) {
+  hooks_ = hooks;
+
+  for (size_t page = 0; page < PAGE_COUNT; ++page) {
+    update_pointers(page);
+  }
+}
+
+void Bus::stopped() {
+  for (const DeviceRange &range : devices_) {
+    range.device->stopped();
+  }
+}
+
+/**
+ * Find the device an address is mapped to, the most recently mapped one if
+ * there are more.
+ */
+Device *Bus::device_at(address addr) const {
+  for (auto it = devices_.rbegin(); it != devices_.rend(); ++it) {
+    if (addr.inner() >= it->first.inner() && addr.inner() <= it->last.inner()) {
+      return it->device;
+    }
+  }
+
+  return nullptr;
+}
+
+/**
+ * Read a device register, see @ref set_device_replay.
+ */
+std::byte Bus::read_device(Device *device, address address) const {
+  if (replay_ == nullptr) {
+    return device->read(address);
+  }
+
+  if (!replay_->replaying) {
+    std::byte value = device->read(address);
+    replay_->reads.push_back(value);
+
+    return value;
+  }
+
+  if (replay_->next < replay_->reads.size()) {
+    return replay_->reads[replay_->next++];
+  }
+
+  // more reads than the recorded run, which is the caller's to find
+  return device->peek(address);
+}
+
+/**
+ * Read an address on a page with a device, or any address while hooks are
+ * set, see @ref read.
+ */
+std::byte Bus::read_slow(address address) const {
+  Device *device = pages_[page_of(address)].device ? device_at(address)
+                                                   : nullptr;
+
+  std::byte value =
+      device != nullptr
+          ? read_device(device, address)
+          : pages_[page_of(address)].storage[address.inner() % PAGE_SIZE];
+
+  if (hooks_ != nullptr) {
+    hooks_->memory_read(address, value);
+  }
+
+  return value;
+}
+
+/**
+ * Read an address without reporting it and without the side effects of
+ * device reads, see @ref fetch.
+ */
+std::byte Bus::fetch_slow(address address) const {
+  Device *device = pages_[page_of(address)].device ? device_at(address)
+                                                   : nullptr;
+
+  if (device != nullptr) {
+    return device->peek(address);
+  }
+
+  return pages_[page_of(address)].storage[address.inner() % PAGE_SIZE];
+}
+
+/**
+ * Write to ROM, a device or a page with decoded code, or to any address while
+ * hooks are set, see @ref write.
+ */
+void Bus::write_slow(address address, std::byte value) {
+  size_t page = page_of(address);
+
+  invalidate_code(page);
+
+  Device *device = pages_[page].device ? device_at(address) : nullptr;
+
+  if (device != nullptr) {
+    if (replay_ == nullptr || !replay_->replaying) {
+      device->write(address, value);
+    }
+  } else if (pages_[page].writable) {
+    pages_[page].storage[address.inner() % PAGE_SIZE] = value;
+  }
+
+  if (hooks_ != nullptr) {
+    hooks_->memory_write(address, value);
+  }
+}
@@ -0,0 +1,236 @@
+#ifndef _H_BUS
+#define _H_BUS
+
+#include "address.h"
+#include "device.h"
+#include "gp_memory.h"
+#include "hooks.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * The device reads of a run of code, for a second run from the same state
+ * (see @ref Bus::set_device_replay).
+ */
+struct DeviceReplay {
+  std::vector<std::byte> reads;
+  /// The next read to replay.
+  size_t next = 0;
+  /// Replay the reads and drop device writes, instead of recording the reads.
+  bool replaying = false;
+};
+
+/**
+ * The address space as the CPU sees it: 256 pages, each mapped to RAM, ROM or
+ * devices.
+ *
+ * Every page points at its backing storage for reads and, unless it is
+ * write-protected, for writes, so a plain RAM access is a page lookup and a
+ * load or store. A missing pointer sends the access to the out-of-line slow
+ * path, which handles ROM, devices and pages holding decoded code.
+ *
+ * Devices are mapped to arbitrary address ranges. Addresses on a device page
+ * that no device covers still reach the storage of the page.
+ *
+ * While memory hooks are set (see @ref set_hooks), no page has a pointer, so
+ * every access takes the slow path, which reports it.
+ */
+class Bus {
+  // the compiled code accesses the page table and the code version directly
+  friend class Jit;
+
+private:
+  struct Page {
+    /// The storage mapped to the page.
+    std::byte *storage = nullptr;
+    /// The storage is RAM, not ROM.
+    bool writable = true;
+    /// At least one device is mapped to the page.
+    bool device = false;
+    /// The page holds decoded code (see @ref mark_code_page).
+    bool code = false;
+  };
+
+  struct DeviceRange {
+    address first, last;
+    Device *device;
+  };
+
+  /// Storage of every page for reads, or nullptr if a device is on it.
+  std::array<const std::byte *, PAGE_COUNT> read_pages_{};
+  /// Storage of every page for writes, or nullptr if writes take the slow
+  /// path (ROM, a device or decoded code on the page).
+  std::array<std::byte *, PAGE_COUNT> write_pages_{};
+
+  std::array<Page, PAGE_COUNT> pages_{};
+  std::vector<DeviceRange> devices_;
+
+  std::byte *ram_;
+
+  /// Bumped on every write to a page that holds decoded code.
+  std::array<uint32_t, PAGE_COUNT> page_versions_{};
+  /// Bumped on every write to any page that holds decoded code.
+  uint64_t code_version_ = 0;
+
+  ExecutionHooks *hooks_ = nullptr;
+  DeviceReplay *replay_ = nullptr;
+
+  Device *device_at(address addr) const;
+  void update_pointers(size_t page);
+  void invalidate_code(size_t page);
+  void map_storage(size_t first_page, size_t pages, std::byte *storage,
+                   bool writable);
+
+  std::byte read_device(Device *device, address address) const;
+  std::byte read_slow(address address) const;
+  std::byte fetch_slow(address address) const;
+  void write_slow(address address, std::byte value);
+
+public:
+  /**
+   * Create a bus with the @ref MEMORY_SIZE bytes at @p ram mapped as RAM to
+   * the whole address space.
+   *
+   * @throws CPUException If the memory is null.
+   */
+  explicit Bus(std::byte *ram);
+
+  /**
+   * Create a bus with all of @p ram mapped to the whole address space.
+   *
+   * @throws CPUException If the memory is null.
+   */
+  explicit Bus(GP_Memory *ram);
+
+  /// The storage mapped by default, see @ref Bus(std::byte *).
+  const std::byte *ram() const { return ram_; }
+  std::byte *ram() { return ram_; }
+
+  /**
+   * Map @p pages pages of RAM starting at @p storage to the pages from
+   * @p first_page on.
+   */
+  void map_ram(size_t first_page, size_t pages, std::byte *storage);
+
+  /**
+   * Map @p pages pages of ROM starting at @p storage to the pages from
+   * @p first_page on. Writes to them are ignored.
+   */
+  void map_rom(size_t first_page, size_t pages, const std::byte *storage);
+
+  /**
+   * Pass reads and writes of the addresses from @p first to @p last
+   * (inclusive) to @p device. Devices mapped later take precedence.
+   *
+   * @throws CPUException If the device is null or the range is empty.
+   */
+  void map_device(address first, address last, Device *device);
+
+  /**
+   * Read an address.
+   *
+   * Always inlined, the threaded core is too large for the inliner to
+   * inline it on its own.
+   *
+   * @param address The address to read.
+   * @return std::byte The byte at the address.
+   */
+  [[gnu::always_inline]] std::byte read(address address) const {
+    const std::byte *storage = read_pages_[page_of(address)];
+
+    if (storage == nullptr) [[unlikely]] {
+      return read_slow(address);
+    }
+
+    return storage[address.inner() % PAGE_SIZE];
+  }
+
+  /**
+   * Read an instruction byte. Like @ref read, but not reported to the memory
+   * hooks (see @ref set_hooks) and without the side effects of device reads
+   * (see @ref Device::peek), so it also serves to inspect memory.
+   */
+  [[gnu::always_inline]] std::byte fetch(address address) const {
+    const std::byte *storage = read_pages_[page_of(address)];
+
+    if (storage == nullptr) [[unlikely]] {
+      return fetch_slow(address);
+    }
+
+    return storage[address.inner() % PAGE_SIZE];
+  }
+
+  /// Fetch from a raw address, see @ref fetch and @ref read(size_t).
+  std::byte fetch(size_t address) const {
+    return fetch(::address(static_cast<uint16_t>(address)));
+  }
+
+  /**
+   * Read a raw address. The address wraps around the end of the address
+   * space.
+   */
+  std::byte read(size_t address) const {
+    return read(::address(static_cast<uint16_t>(address)));
+  }
+
+  /**
+   * Write a value to an address.
+   *
+   * Writing to a page that holds decoded code invalidates the code decoded
+   * from the page. Writes to ROM are ignored.
+   *
+   * @param address The address to write to.
+   * @param value The value to write.
+   */
+  [[gnu::always_inline]] void write(address address, std::byte value) {
+    std::byte *storage = write_pages_[page_of(address)];
+
+    if (storage == nullptr) [[unlikely]] {
+      write_slow(address, value);
+
+      return;
+    }
+
+    storage[address.inner() % PAGE_SIZE] = value;
+  }
+
+  /**
+   * Report every read and write to @p hooks (see
+   * @ref ExecutionHooks::memory_read), or stop reporting them if it is null.
+   * Not owned by the bus.
+   */
+  void set_hooks(ExecutionHooks *hooks);
+
+  /**
+   * Record the device reads into @p replay, or, once it is replaying, answer
+   * them from it and drop the device writes, so that devices only see one of
+   * two runs of the same code. Stops if it is null. Not owned by the bus.
+   */
+  void set_device_replay(DeviceReplay *replay) { replay_ = replay; }
+
+  /// Tell all devices that the CPU stopped running, see @ref Device::stopped.
+  void stopped();
+
+  /// Is there a device on the page?
+  bool has_device(size_t page) const { return pages_[page].device; }
+
+  /**
+   * Mark a page as holding decoded code. The next write to the page bumps its
+   * version, after which the code decoded from it has to be decoded again.
+   */
+  void mark_code_page(size_t page) {
+    pages_[page].code = true;
+    write_pages_[page] = nullptr;
+  }
+
+  /// Version of a page, changes whenever decoded code on it is overwritten.
+  uint32_t page_version(size_t page) const { return page_versions_[page]; }
+
+  /// Changes whenever decoded code on any page is overwritten.
+  uint64_t code_version() const { return code_version_; }
+};
+
+#endif
@@ -5,14 +5,14 @@ int16_t Debugger::twos_complement(uint8_t byte) {
   return static_cast<int16_t>(static_cast<int8_t>(byte));
 }
 
-void Debugger::print_memory(std::ostream &stream, GP_Memory *memory,
-                            size_t start, size_t count) {
+void Debugger::print_memory(std::ostream &stream, const Bus *bus, size_t start,
+                            size_t count) {
   for (size_t i = 0; i < count; ++i) {
     if (i % 16 == 0) {
       stream << std::endl
              << std::hex << std::setw(4) << std::setfill('0') << start + i
              << ": " << std::hex << std::setw(2) << std::setfill('0')
-             << static_cast<int>(memory->read(start + i));
+             << static_cast<int>(bus->fetch(start + i));
 
       continue;
     }
@@ -24,7 +24,7 @@ void Debugger::print_memory(std::ostream &stream, GP_Memory *memory,
     }
 
     stream << std::hex << std::setw(2) << std::setfill('0')
-           << static_cast<int>(memory->read(start + i));
+           << static_cast<int>(bus->fetch(start + i));
   }
 
   stream << std::endl << std::endl;
@@ -77,7 +77,7 @@ bool Debugger::go_to_debugger() {
         // get one byte
         size_t address = hex_to_number(cmd->args[0]);
 
-        print_memory(std::cout, cpu_->get_memory(), address, 1);
+        print_memory(std::cout, cpu_->get_bus(), address, 1);
 
         continue;
       }
@@ -86,7 +86,7 @@ bool Debugger::go_to_debugger() {
         size_t start = hex_to_number(cmd->args[0]);
         size_t count = hex_to_number(cmd->args[1]);
 
-        print_memory(std::cout, cpu_->get_memory(), start, count);
+        print_memory(std::cout, cpu_->get_bus(), start, count);
 
         continue;
       }
@@ -98,6 +98,9 @@ bool Debugger::go_to_debugger() {
     case Command::Name::STEP: {
       InstructionErr err = cpu_->step();
 
+      // show the output of the instruction right away
+      cpu_->get_bus()->stopped();
+
       if (err == InstructionErr::GoToDebugger) {
         std::cout << std::endl << BREAKPOINT_MSG << std::endl;
 
@@ -119,7 +122,8 @@ bool Debugger::go_to_debugger() {
       continue;
     }
     case Command::Name::EXIT: {
-      exit(0);
+      // returning lets the devices write out their buffered output
+      return true;
     }
     default:
       continue;
@@ -4,7 +4,7 @@
 #include "6502cpu.h"
 #include "address.h"
 #include "byte_utils.h"
-#include "gp_memory.h"
+#include "bus.h"
 #include "instruction_types.h"
 
 #include <bitset>
@@ -125,23 +125,29 @@ public:
   Debugger(CPU6502 *cpu, DebuggerOptions &&options)
       : cpu_(cpu), options_(std::move(options)) {}
 
-  void print_memory(std::ostream &stream, GP_Memory *memory, size_t start,
+  /**
+   * Print @p count bytes from @p start on, without the side effects of device
+   * reads (see @ref Bus::fetch).
+   */
+  void print_memory(std::ostream &stream, const Bus *bus, size_t start,
                     size_t count);
 
   bool go_to_debugger();
 
   void run() {
-    while (cpu_->get_PC().inner() < cpu_->get_memory()->size()) {
-      InstructionErr err = cpu_->step();
+    while (true) {
+      InstructionErr err = cpu_->run();
 
       if (err == InstructionErr::GoToDebugger) {
-        std::cout << std::endl << BREAKPOINT_MSG << std::endl;
+        std::cout << '\n' << BREAKPOINT_MSG << std::endl;
 
         if (go_to_debugger()) {
           return;
         }
-      } else if (err == InstructionErr::Stop) {
-        std::cout << std::endl << STP_MSG << std::endl;
+      } else {
+        if (err == InstructionErr::Stop) {
+          std::cout << '\n' << STP_MSG << '\n';
+        }
 
         return;
       }
@@ -0,0 +1,81 @@
+#include "decimal.h"
+
+/*
+ * Decimal arithmetic of the W65C02S, following the sequences in "Decimal
+ * Mode" by Bruce Clark (6502.org). The tables cover invalid BCD operands
+ * too, with the results the chip gives for them.
+ */
+
+/**
+ * ADC: add the digits one by one, adjusting each above 9. V comes from the
+ * signed sum after the low digit was adjusted, before the high one is.
+ */
+static constexpr DecimalResult decimal_adc(bool carry, uint8_t a, uint8_t m) {
+  int low = (a & 0x0F) + (m & 0x0F) + carry;
+
+  if (low >= 0x0A) {
+    low = ((low + 0x06) & 0x0F) + 0x10;
+  }
+
+  int sum = (a & 0xF0) + (m & 0xF0) + low;
+  int signed_sum =
+      static_cast<int8_t>(a & 0xF0) + static_cast<int8_t>(m & 0xF0) + low;
+
+  if (sum >= 0xA0) {
+    sum += 0x60;
+  }
+
+  DecimalResult result;
+  result.value = static_cast<uint8_t>(sum);
+  result.flags = static_cast<uint8_t>(
+      (sum >= 0x100 ? DECIMAL_CARRY : 0) |
+      (signed_sum < -128 || signed_sum > 127 ? DECIMAL_OVERFLOW : 0));
+
+  return result;
+}
+
+/**
+ * SBC: subtract in binary, then adjust each digit that borrowed. C and V are
+ * the same as in binary mode.
+ */
+static constexpr DecimalResult decimal_sbc(bool carry, uint8_t a, uint8_t m) {
+  int borrow = carry ? 0 : 1;
+  int low = (a & 0x0F) - (m & 0x0F) - borrow;
+  int difference = a - m - borrow;
+  int signed_difference =
+      static_cast<int8_t>(a) - static_cast<int8_t>(m) - borrow;
+
+  int adjusted = difference;
+
+  if (adjusted < 0) {
+    adjusted -= 0x60;
+  }
+
+  if (low < 0) {
+    adjusted -= 0x06;
+  }
+
+  DecimalResult result;
+  result.value = static_cast<uint8_t>(adjusted);
+  result.flags = static_cast<uint8_t>(
+      (difference >= 0 ? DECIMAL_CARRY : 0) |
+      (signed_difference < -128 || signed_difference > 127 ? DECIMAL_OVERFLOW
+                                                           : 0));
+
+  return result;
+}
+
+template <DecimalResult (*Operation)(bool, uint8_t, uint8_t)>
+static constexpr DecimalTable make_decimal_table() {
+  DecimalTable table{};
+
+  for (size_t i = 0; i < table.size(); ++i) {
+    table[i] = Operation((i >> 16) != 0, static_cast<uint8_t>(i >> 8),
+                         static_cast<uint8_t>(i));
+  }
+
+  return table;
+}
+
+extern constexpr DecimalTable DECIMAL_ADC = make_decimal_table<decimal_adc>();
+extern constexpr DecimalTable DECIMAL_SBC = make_decimal_table<decimal_sbc>();
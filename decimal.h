@@ -0,0 +1,38 @@
+#ifndef _H_DECIMAL
+#define _H_DECIMAL
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * The result of a decimal mode ADC or SBC. N and Z follow from the value on
+ * the W65C02S.
+ */
+struct DecimalResult {
+  /// The new accumulator.
+  uint8_t value = 0;
+  /// C in bit 0, V in bit 7 (see @ref DECIMAL_CARRY and @ref DECIMAL_OVERFLOW).
+  uint8_t flags = 0;
+};
+
+constexpr uint8_t DECIMAL_CARRY = 0x01;
+constexpr uint8_t DECIMAL_OVERFLOW = 0x80;
+
+/**
+ * Results of one decimal operation for every carry, accumulator and operand,
+ * indexed by @ref decimal_index.
+ */
+using DecimalTable = std::array<DecimalResult, 2 * 256 * 256>;
+
+/// The entry of a @ref DecimalTable for @p carry, @p a and @p m.
+constexpr size_t decimal_index(bool carry, uint8_t a, uint8_t m) {
+  return static_cast<size_t>(carry) << 16 | static_cast<size_t>(a) << 8 | m;
+}
+
+/// ADC in decimal mode, computed at compile time.
+extern const DecimalTable DECIMAL_ADC;
+/// SBC in decimal mode, computed at compile time.
+extern const DecimalTable DECIMAL_SBC;
+
+#endif
@@ -0,0 +1,203 @@
+#include "6502cpu.h"
+#include "6502isa.h"
+#include "address.h"
+#include "instruction_types.h"
+#include "psr.h"
+#include "unit_test.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+
+/// The accumulator and flags after a decimal ADC or SBC.
+struct Expected {
+  uint8_t value = 0;
+  bool n = false, v = false, z = false, c = false;
+};
+
+/// A digit as a signed 4-bit number.
+static int signed_digit(int digit) { return digit >= 8 ? digit - 16 : digit; }
+
+/**
+ * ADC in decimal mode on the W65C02S, as described in "Decimal Mode" by Bruce
+ * Clark (6502.org), but digit by digit: a digit above 9 is adjusted by 6 and
+ * carries into the next one, and V comes from the signed high digits plus the
+ * carry out of the low one. N and Z follow from the result.
+ */
+static Expected reference_adc(bool carry, uint8_t a, uint8_t m) {
+  int low = (a & 0x0F) + (m & 0x0F) + (carry ? 1 : 0);
+  bool low_carry = low > 9;
+
+  if (low_carry) {
+    low = (low + 6) & 0x0F;
+  }
+
+  int high = (a >> 4) + (m >> 4) + (low_carry ? 1 : 0);
+  int signed_high =
+      signed_digit(a >> 4) + signed_digit(m >> 4) + (low_carry ? 1 : 0);
+
+  Expected expected;
+  expected.c = high > 9;
+
+  if (expected.c) {
+    high = (high + 6) & 0x0F;
+  }
+
+  expected.value = static_cast<uint8_t>(high << 4 | low);
+  expected.v = signed_high < -8 || signed_high > 7;
+  expected.n = (expected.value & 0x80) != 0;
+  expected.z = expected.value == 0;
+
+  return expected;
+}
+
+/**
+ * SBC in decimal mode on the W65C02S, from the same document: a binary
+ * subtraction, less 0x60 if it borrowed and less 6 if the low digit
+ * borrowed. C and V are those of the binary subtraction.
+ */
+static Expected reference_sbc(bool carry, uint8_t a, uint8_t m) {
+  int borrow = carry ? 0 : 1;
+  int binary = (a - m - borrow) & 0xFF;
+
+  Expected expected;
+  expected.c = a >= m + borrow;
+  expected.v = ((a ^ m) & (a ^ binary) & 0x80) != 0;
+
+  int adjusted = binary - (expected.c ? 0 : 0x60) -
+                 ((a & 0x0F) < (m & 0x0F) + borrow ? 6 : 0);
+
+  expected.value = static_cast<uint8_t>(adjusted & 0xFF);
+  expected.n = (expected.value & 0x80) != 0;
+  expected.z = expected.value == 0;
+
+  return expected;
+}
+
+/// A byte holding @p value (0 to 99) in BCD.
+static uint8_t to_bcd(int value) {
+  return static_cast<uint8_t>((value / 10) << 4 | value % 10);
+}
+
+/**
+ * Check the references against plain decimal arithmetic, for all valid BCD
+ * operands and both carries.
+ */
+static void check_references() {
+  for (int carry = 0; carry < 2; ++carry) {
+    for (int a = 0; a < 100; ++a) {
+      for (int m = 0; m < 100; ++m) {
+        int sum = a + m + carry;
+        int difference = a - m - (1 - carry);
+
+        Expected adc = reference_adc(carry != 0, to_bcd(a), to_bcd(m));
+        Expected sbc = reference_sbc(carry != 0, to_bcd(a), to_bcd(m));
+
+        if (!check(adc.value == to_bcd(sum % 100) && adc.c == (sum >= 100),
+                   std::format("reference ADC {} + {} + {}", a, m, carry)) ||
+            !check(sbc.value == to_bcd((difference + 100) % 100) &&
+                       sbc.c == (difference >= 0),
+                   std::format("reference SBC {} - {} - {}", a, m,
+                               1 - carry))) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Run the ADC or SBC immediate @p opcode in decimal mode for every carry,
+ * accumulator and operand, and compare the accumulator, the flags and the
+ * cycles with @p reference.
+ */
+static void check_exhaustive(const char *name, uint8_t opcode,
+                             Expected (*reference)(bool, uint8_t, uint8_t)) {
+  TestMachine machine;
+  CPU6502 &cpu = machine.cpu;
+  machine.load(TEST_CODE, {opcode});
+
+  for (int carry = 0; carry < 2; ++carry) {
+    for (int a = 0; a < 256; ++a) {
+      for (int m = 0; m < 256; ++m) {
+        machine.load(TEST_CODE + 1, {static_cast<uint8_t>(m)});
+
+        cpu.set_PC(address(TEST_CODE));
+        cpu.set_A(std::byte(a));
+        cpu.get_PSR()->set_bit(psr_bit::decimal_mode, true);
+        cpu.get_PSR()->set_bit(psr_bit::carry, carry != 0);
+
+        uint64_t cycles = cpu.get_cycles();
+        InstructionErr err = cpu.step();
+
+        Expected expected = reference(carry != 0, static_cast<uint8_t>(a),
+                                      static_cast<uint8_t>(m));
+        const PSR *psr = cpu.get_PSR();
+
+        bool same =
+            err == InstructionErr::OK &&
+            std::to_integer<uint8_t>(cpu.get_A()) == expected.value &&
+            psr->get_bit(psr_bit::negative) == expected.n &&
+            psr->get_bit(psr_bit::overflow) == expected.v &&
+            psr->get_bit(psr_bit::zero) == expected.z &&
+            psr->get_bit(psr_bit::carry) == expected.c &&
+            cpu.get_cycles() - cycles == 3;
+
+        if (!check(same,
+                   std::format("{} A={:02x} M={:02x} C={}: got {:02x} P={:08b} "
+                               "in {} cycles, expected {:02x} N={} V={} Z={} "
+                               "C={}",
+                               name, a, m, carry,
+                               std::to_integer<int>(cpu.get_A()),
+                               std::to_integer<int>(psr->get()),
+                               cpu.get_cycles() - cycles,
+                               static_cast<int>(expected.value),
+                               expected.n, expected.v, expected.z,
+                               expected.c))) {
+          return;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Check that every ADC and SBC takes one cycle more in decimal mode than in
+ * binary mode, whatever its addressing mode.
+ */
+static void check_decimal_cycle() {
+  for (size_t opcode = 0; opcode < isa.size(); ++opcode) {
+    const Instruction &instruction = isa[opcode];
+
+    if (!instruction.valid() ||
+        (instruction.mnemonic != mnemonic_index("ADC") &&
+         instruction.mnemonic != mnemonic_index("SBC"))) {
+      continue;
+    }
+
+    uint64_t cycles[2] = {};
+
+    for (int decimal = 0; decimal < 2; ++decimal) {
+      TestMachine machine;
+      machine.load(TEST_CODE, {static_cast<uint8_t>(opcode)});
+      machine.cpu.get_PSR()->set_bit(psr_bit::decimal_mode, decimal != 0);
+
+      machine.cpu.step();
+      cycles[decimal] = machine.cpu.get_cycles();
+    }
+
+    check(cycles[1] == cycles[0] + 1,
+          std::format("{:02x} takes {} cycles in decimal mode, {} in binary "
+                      "mode",
+                      opcode, cycles[1], cycles[0]));
+  }
+}
+
+int main() {
+  check_references();
+  check_exhaustive("ADC", 0x69, reference_adc);
+  check_exhaustive("SBC", 0xE9, reference_sbc);
+  check_decimal_cycle();
+
+  return finish_checks("decimal");
+}
@@ -0,0 +1,46 @@
+#ifndef _H_DEVICE
+#define _H_DEVICE
+
+#include "address.h"
+
+#include <cstddef>
+
+/**
+ * A memory-mapped device. Reads and writes of the addresses it is mapped to
+ * (see @ref Bus::map_device) are passed to it instead of the memory.
+ */
+class Device {
+public:
+  virtual ~Device() = default;
+
+  /**
+   * Read the register at @p addr.
+   *
+   * @param addr An address inside the range the device is mapped to.
+   */
+  virtual std::byte read(address addr) = 0;
+
+  /**
+   * Write @p value to the register at @p addr.
+   *
+   * @param addr An address inside the range the device is mapped to.
+   */
+  virtual void write(address addr, std::byte value) = 0;
+
+  /**
+   * Read the register at @p addr without side effects, for instruction
+   * fetches and the debugger (see @ref Bus::fetch). Devices whose reads have
+   * side effects override it; by default it reads the register.
+   *
+   * @param addr An address inside the range the device is mapped to.
+   */
+  virtual std::byte peek(address addr) { return read(addr); }
+
+  /**
+   * Called when the CPU stops running (see @ref CPU6502::run). Devices that
+   * buffer output write it out here.
+   */
+  virtual void stopped() {}
+};
+
+#endif
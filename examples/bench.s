@@ -0,0 +1,40 @@
+    .include "includes/debug.inc"
+    .include "includes/print.inc"
+
+    .org $0000
+
+    .org $8000
+
+; ALU-heavy busy loop used by the benchmark (`make bench`).
+; Executes roughly 12.5 million instructions before stopping.
+start:
+    lda #16
+    sta $12         ; outer loop counter
+    lda #0
+    sta $10
+    sta $11
+outer2:
+    ldy #0
+outer:
+    ldx #0
+inner:
+    txa
+    clc
+    adc $10
+    sta $10
+    eor #$5A
+    asl a
+    rol $11
+    lsr a
+    sbc #3
+    sta $0200,x
+    dex
+    bne inner
+    dey
+    bne outer
+    dec $12
+    bne outer2
+    stp
+
+    .org $fffc
+    .word start
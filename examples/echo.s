@@ -0,0 +1,18 @@
+    .include "includes/input.inc"
+    .include "includes/print.inc"
+
+    .org $0000
+
+    .org $8000
+
+start:
+    WAITKEY         ; wait for a byte of input
+    bvs done        ; the input has ended
+    lda INPUT_DATA  ; read the byte
+    PRINT           ; and echo it
+    jmp start
+done:
+    stp             ; stop execution
+
+    .org $fffc
+    .word start
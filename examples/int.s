@@ -8,6 +8,7 @@
 start:
     lda #1
     brk
+    .byte 0     ; signature byte, RTI returns past it
     stp
 
 int:
@@ -0,0 +1,38 @@
+    .include "includes/print.inc"
+    .include "includes/timer.inc"
+
+TICKS = $00
+
+    .org $0000
+
+    .org $8000
+
+start:
+    lda #10
+    sta TICKS       ; number of ticks to print
+    lda #<9999
+    ldx #>9999
+    ldy #TIMER_FREE_RUN | TIMER_IRQ_ENABLE
+    STARTTIMER      ; one tick every 10000 cycles
+    cli
+wait:
+    wai             ; sleep until the next tick
+    lda TICKS
+    bne wait
+    lda #10
+    PRINT
+    stp             ; stop execution
+
+tick:
+    pha
+    ACKTIMER
+    lda #'.'
+    PRINT
+    dec TICKS
+    pla
+    rti
+
+    .org $fffc
+    .word start
+    .org $fffe      ; interrupt handler
+    .word tick
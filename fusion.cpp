@@ -0,0 +1,281 @@
+#include "fusion.h"
+#include "6502cpu.h"
+#include "6502isa.h"
+#include "address.h"
+#include "block_cache.h"
+#include "instruction_types.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+/// The longest idiom, in instructions.
+constexpr size_t MAX_IDIOM = 3;
+
+/// The opcodes of an idiom, in order.
+struct Idiom {
+  std::array<uint8_t, MAX_IDIOM> opcodes{};
+  uint8_t length = 0;
+};
+
+constexpr size_t IDIOM_COUNT = 86;
+
+/**
+ * The fused idioms. Longer ones come first, so they win over a pair they
+ * start with.
+ */
+constexpr std::array<Idiom, IDIOM_COUNT> IDIOMS = [] {
+  std::array<Idiom, IDIOM_COUNT> idioms{};
+  size_t count = 0;
+
+  auto pairs = [&](std::initializer_list<uint8_t> firsts,
+                   std::initializer_list<uint8_t> seconds) {
+    for (uint8_t first : firsts) {
+      for (uint8_t second : seconds) {
+        idioms[count++] = {{first, second, 0}, 2};
+      }
+    }
+  };
+
+  // INX/CPX #/BNE and INY/CPY #/BNE, counted loops
+  idioms[count++] = {{0xE8, 0xE0, 0xD0}, 3};
+  idioms[count++] = {{0xC8, 0xC0, 0xD0}, 3};
+
+  // CMP, CPX and CPY (#, zp, abs) followed by BNE, BEQ, BCC or BCS
+  pairs({0xC9, 0xC5, 0xCD, 0xE0, 0xE4, 0xEC, 0xC0, 0xC4, 0xCC},
+        {0xD0, 0xF0, 0x90, 0xB0});
+  // DEX, DEY, INX and INY followed by BNE or BPL
+  pairs({0xCA, 0x88, 0xE8, 0xC8}, {0xD0, 0x10});
+  // LDA (#, zp, abs, abs,X, abs,Y) followed by STA (zp, abs, abs,X, abs,Y)
+  pairs({0xA9, 0xA5, 0xAD, 0xBD, 0xB9}, {0x85, 0x8D, 0x9D, 0x99});
+  // LDA (zp, abs, abs,X, abs,Y, (zp),Y) followed by BEQ, BNE, BPL or BMI
+  pairs({0xA5, 0xAD, 0xBD, 0xB9, 0xB1}, {0xF0, 0xD0, 0x10, 0x30});
+
+  if (count != IDIOM_COUNT) {
+    throw std::invalid_argument("IDIOM_COUNT does not match the idioms.");
+  }
+
+  // the operands after the first one have to fit in fused_operands
+  for (const Idiom &idiom : idioms) {
+    size_t bytes = 0;
+
+    for (size_t part = 1; part < idiom.length; ++part) {
+      bytes += isa[idiom.opcodes[part]].bytes - 1u;
+    }
+
+    if (bytes > sizeof(address)) {
+      throw std::invalid_argument("The operands of an idiom do not fit.");
+    }
+  }
+
+  return idioms;
+}();
+
+/// Runs of each idiom, counted by handlers fused with counting on.
+std::array<std::atomic<uint64_t>, IDIOM_COUNT> idiom_runs{};
+
+/**
+ * Where the operand of instruction @p Part of an idiom starts in
+ * @ref DecodedInstruction::fused_operands.
+ */
+template <size_t Index, size_t Part>
+constexpr size_t fused_offset() {
+  size_t offset = 0;
+
+  for (size_t part = 1; part < Part; ++part) {
+    offset += isa[IDIOMS[Index].opcodes[part]].bytes - 1u;
+  }
+
+  return offset;
+}
+
+/// The operand of instruction @p Part of an idiom, as it was decoded.
+template <size_t Index, size_t Part>
+[[gnu::always_inline]] inline address
+operand_of(const DecodedInstruction &instruction) {
+  constexpr uint8_t bytes = isa[IDIOMS[Index].opcodes[Part]].bytes;
+  constexpr size_t offset = fused_offset<Index, Part>();
+
+  if constexpr (Part == 0) {
+    return instruction.operand;
+  } else if constexpr (bytes == 3) {
+    return instruction.fused_operands;
+  } else if constexpr (bytes == 2) {
+    return address(offset == 0 ? instruction.fused_operands.low()
+                               : instruction.fused_operands.high());
+  } else {
+    return address();
+  }
+}
+
+/**
+ * Run the instructions of an idiom from the one at @p Part on. The
+ * instruction at @p Part has its cycles counted already, the following ones
+ * count theirs before they run, exactly like in @ref CPU6502::run_block.
+ */
+template <size_t Index, size_t Part>
+[[gnu::always_inline]] inline InstructionErr
+run_idiom(CPU6502 &cpu, const DecodedInstruction &instruction) {
+  constexpr Idiom idiom = IDIOMS[Index];
+  constexpr Instruction part = isa[idiom.opcodes[Part]];
+
+  InstructionErr err = part.execute(cpu, operand_of<Index, Part>(instruction));
+
+  if constexpr (Part + 1 == idiom.length) {
+    return err;
+  } else {
+    // only the last instruction of an idiom branches
+    if (err != InstructionErr::OK) {
+      return err;
+    }
+
+    cpu.count_cycles(isa[idiom.opcodes[Part + 1]].cycles);
+
+    return run_idiom<Index, Part + 1>(cpu, instruction);
+  }
+}
+
+/// The fused handler of an idiom, see @ref fuse_idioms.
+template <size_t Index, bool Count>
+InstructionErr fused(CPU6502 &cpu, const DecodedInstruction &instruction) {
+  if constexpr (Count) {
+    idiom_runs[Index].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  return run_idiom<Index, 0>(cpu, instruction);
+}
+
+template <bool Count, size_t... Indices>
+constexpr std::array<DecodedHandler, IDIOM_COUNT>
+make_handlers(std::index_sequence<Indices...>) {
+  return {fused<Indices, Count>...};
+}
+
+constexpr std::array<DecodedHandler, IDIOM_COUNT> FUSED_HANDLERS =
+    make_handlers<false>(std::make_index_sequence<IDIOM_COUNT>());
+constexpr std::array<DecodedHandler, IDIOM_COUNT> COUNTING_HANDLERS =
+    make_handlers<true>(std::make_index_sequence<IDIOM_COUNT>());
+
+/// Do the instructions from @p first on start with @p idiom?
+bool matches(const Idiom &idiom, const DecodedInstruction *first,
+             size_t left) {
+  if (idiom.length > left) {
+    return false;
+  }
+
+  for (size_t i = 0; i < idiom.length; ++i) {
+    if (first[i].opcode != idiom.opcodes[i]) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// The assembler notation of an addressing mode, for the statistics.
+const char *mode_notation(AddressingMode mode) {
+  switch (mode) {
+  case AddressingMode::Absolute:
+    return " abs";
+  case AddressingMode::AbsoluteIndexedX:
+    return " abs,X";
+  case AddressingMode::AbsoluteIndexedY:
+    return " abs,Y";
+  case AddressingMode::Immediate:
+    return " #";
+  case AddressingMode::ZeroPage:
+    return " zp";
+  case AddressingMode::ZeroPageIndirectIndexedY:
+    return " (zp),Y";
+  default:
+    return "";
+  }
+}
+
+} // namespace
+
+void fuse_idioms(const std::vector<DecodedInstruction> &instructions,
+                 std::vector<DecodedInstruction> &fused, bool count) {
+  const std::array<DecodedHandler, IDIOM_COUNT> &handlers =
+      count ? COUNTING_HANDLERS : FUSED_HANDLERS;
+
+  for (size_t i = 0; i < instructions.size();) {
+    const DecodedInstruction &first = instructions[i];
+    size_t left = instructions.size() - i;
+
+    auto idiom = std::find_if(IDIOMS.begin(), IDIOMS.end(),
+                              [&](const Idiom &candidate) {
+                                return matches(candidate, &first, left);
+                              });
+
+    fused.push_back(first);
+
+    if (idiom == IDIOMS.end()) {
+      ++i;
+      continue;
+    }
+
+    DecodedInstruction &fused_idiom = fused.back();
+    fused_idiom.execute = handlers[static_cast<size_t>(idiom - IDIOMS.begin())];
+
+    // pack the operands of the following instructions, see operand_of
+    std::array<std::byte, sizeof(address)> operands{};
+    size_t offset = 0;
+
+    for (size_t part = 1; part < idiom->length; ++part) {
+      const DecodedInstruction &next = instructions[i + part];
+
+      if (next.bytes >= 2) {
+        operands[offset++] = next.operand.low();
+      }
+
+      if (next.bytes == 3) {
+        operands[offset++] = next.operand.high();
+      }
+    }
+
+    fused_idiom.fused_operands = address(operands[0], operands[1]);
+
+    i += idiom->length;
+  }
+}
+
+void print_fusion_stats(std::ostream &stream) {
+  std::array<std::pair<uint64_t, size_t>, IDIOM_COUNT> runs;
+
+  for (size_t i = 0; i < IDIOM_COUNT; ++i) {
+    runs[i] = {idiom_runs[i].load(std::memory_order_relaxed), i};
+  }
+
+  std::stable_sort(runs.begin(), runs.end(), [](const auto &a, const auto &b) {
+    return a.first > b.first;
+  });
+
+  stream << "Fused idioms:" << std::endl;
+
+  for (const auto &[count, index] : runs) {
+    if (count == 0) {
+      break;
+    }
+
+    const Idiom &idiom = IDIOMS[index];
+
+    stream << " ";
+
+    for (size_t i = 0; i < idiom.length; ++i) {
+      const Instruction &instruction = isa[idiom.opcodes[i]];
+
+      stream << (i == 0 ? " " : " / ") << instruction.name()
+             << mode_notation(instruction.mode);
+    }
+
+    stream << ": " << count << std::endl;
+  }
+}
@@ -0,0 +1,36 @@
+#ifndef _H_FUSION
+#define _H_FUSION
+
+#include "block_cache.h"
+
+#include <ostream>
+#include <vector>
+
+/**
+ * Copy the decoded @p instructions of a block to @p fused, replacing common
+ * idioms with one instruction each.
+ *
+ * A fused handler runs all instructions of its idiom in one dispatch: a
+ * comparison, load or count followed by a branch, or a load followed by a
+ * store (`CMP #/BNE`, `DEX/BNE`, `LDA/STA`, `INX/CPX #/BNE`,
+ * `LDA abs,X/BEQ`, ...). It takes the place of the first instruction and
+ * keeps its operand and base cycles.
+ *
+ * Every instruction of an idiom still runs its own handler, inlined, and
+ * counts its own cycles before it runs, so the CPU, the memory and the
+ * cycles are exactly the same as without fusing. Idioms never span blocks,
+ * and interrupts and events are only taken between blocks anyway.
+ *
+ * @param count Whether the fused handlers count their runs, see
+ * @ref print_fusion_stats.
+ */
+void fuse_idioms(const std::vector<DecodedInstruction> &instructions,
+                 std::vector<DecodedInstruction> &fused, bool count);
+
+/**
+ * Print how many times each idiom ran, most frequent first. Only runs of
+ * handlers fused with counting on are counted, in all caches together.
+ */
+void print_fusion_stats(std::ostream &stream);
+
+#endif
@@ -0,0 +1,198 @@
+#include "fusion.h"
+#include "6502cpu.h"
+#include "6502isa.h"
+#include "address.h"
+#include "block_cache.h"
+#include "instruction_types.h"
+#include "psr.h"
+#include "unit_test.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <format>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/// Where the instructions under test are placed, followed by STP.
+constexpr uint16_t CODE = 0x0400;
+constexpr std::byte STP{0xDB};
+
+/// Runs of every fused idiom, each from another random state.
+constexpr int SAMPLES = 256;
+
+/**
+ * Random bytes, half of them values that make comparisons equal and flags
+ * set more often than uniform ones would.
+ */
+class Random {
+private:
+  std::mt19937 engine_{6502};
+
+public:
+  std::byte next() {
+    constexpr std::array<uint8_t, 5> INTERESTING = {0x00, 0x01, 0x7F, 0x80,
+                                                    0xFF};
+
+    uint32_t value = engine_();
+
+    if (value & 0x100) {
+      return std::byte(INTERESTING[(value >> 9) % INTERESTING.size()]);
+    }
+
+    return std::byte(value & 0xFF);
+  }
+};
+
+/**
+ * Decode @p opcodes at @ref CODE, with operands from @p operand, followed by
+ * STP.
+ */
+static const DecodedBlock *decode(CoreMachine &machine,
+                                  const std::vector<uint8_t> &opcodes,
+                                  const std::function<std::byte()> &operand) {
+  uint16_t pc = CODE;
+
+  for (uint8_t opcode : opcodes) {
+    machine.bus.write(address(pc++), std::byte(opcode));
+
+    for (size_t i = 1; i < isa[opcode].bytes; ++i) {
+      machine.bus.write(address(pc++), operand());
+    }
+  }
+
+  machine.bus.write(address(pc), STP);
+
+  return machine.block_cache.lookup(address(CODE));
+}
+
+/// Does the block start with all of its first @p length instructions fused?
+static bool starts_fused(const DecodedBlock *block, size_t length) {
+  return block != nullptr && block->instructions.size() > length &&
+         block->fused.size() == block->instructions.size() - length + 1;
+}
+
+/**
+ * Run @p opcodes fused and one by one from the same random states, and
+ * compare the registers, the flags, the cycles, the memory and the results.
+ */
+static void check_idiom(CoreMachine &machine,
+                        const std::vector<uint8_t> &opcodes, Random &random) {
+  std::vector<std::byte> memory(MEMORY_SIZE);
+  std::vector<std::byte> fused_memory(MEMORY_SIZE);
+
+  for (int sample = 0; sample < SAMPLES; ++sample) {
+    const DecodedBlock *block =
+        decode(machine, opcodes, [&random]() { return random.next(); });
+
+    for (size_t i = 0; i < 256; ++i) {
+      machine.bus.write(address(static_cast<uint16_t>(i)), random.next());
+    }
+
+    CPU6502 &cpu = machine.cpu;
+    cpu.set_PC(address(CODE));
+    cpu.set_A(random.next());
+    cpu.set_X(random.next());
+    cpu.set_Y(random.next());
+    cpu.set_S(random.next());
+    cpu.set_PSR(PSR(random.next()));
+
+    CPU6502 start = cpu;
+    std::memcpy(memory.data(), machine.memory.data(), MEMORY_SIZE);
+
+    InstructionErr fused_err = cpu.run_block(*block);
+    CPU6502 fused = cpu;
+    std::memcpy(fused_memory.data(), machine.memory.data(), MEMORY_SIZE);
+
+    cpu = start;
+    std::memcpy(machine.memory.data(), memory.data(), MEMORY_SIZE);
+
+    // decoded again if the fused run overwrote it, which also marks its page
+    // as code again, so a store to it stops the block as in the fused run
+    DecodedBlock unfused = *machine.block_cache.lookup(address(CODE));
+    unfused.fused = unfused.instructions;
+
+    InstructionErr err = cpu.run_block(unfused);
+
+    bool same =
+        fused_err == err && fused.get_A() == cpu.get_A() &&
+        fused.get_X() == cpu.get_X() && fused.get_Y() == cpu.get_Y() &&
+        fused.get_S() == cpu.get_S() &&
+        fused.get_PSR()->get() == cpu.get_PSR()->get() &&
+        fused.get_PC() == cpu.get_PC() &&
+        fused.get_cycles() == cpu.get_cycles() &&
+        std::memcmp(fused_memory.data(), machine.memory.data(), MEMORY_SIZE) ==
+            0;
+
+    std::string names;
+
+    for (uint8_t opcode : opcodes) {
+      names += std::format(" {} ({:02x})", isa[opcode].name(),
+                           static_cast<int>(opcode));
+    }
+
+    if (!check(same, std::format("{} differs from the unfused run in sample "
+                                 "{}",
+                                 names, sample))) {
+      return;
+    }
+  }
+}
+
+int main() {
+  CoreMachine machine(ExecutionCore::Cached);
+  Random random;
+
+  std::vector<uint8_t> valid;
+
+  for (size_t opcode = 0; opcode < isa.size(); ++opcode) {
+    if (isa[opcode].valid()) {
+      valid.push_back(static_cast<uint8_t>(opcode));
+    }
+  }
+
+  auto zero = []() noexcept { return std::byte{0}; };
+
+  // find the idioms by decoding every pair, and every triple of opcodes that
+  // take part in one
+  std::vector<std::vector<uint8_t>> idioms;
+  std::vector<uint8_t> parts;
+
+  for (uint8_t first : valid) {
+    for (uint8_t second : valid) {
+      if (starts_fused(decode(machine, {first, second}, zero), 2)) {
+        idioms.push_back({first, second});
+        parts.push_back(first);
+        parts.push_back(second);
+      }
+    }
+  }
+
+  std::sort(parts.begin(), parts.end());
+  parts.erase(std::unique(parts.begin(), parts.end()), parts.end());
+
+  for (uint8_t first : parts) {
+    for (uint8_t second : parts) {
+      for (uint8_t third : parts) {
+        if (starts_fused(decode(machine, {first, second, third}, zero), 3)) {
+          idioms.push_back({first, second, third});
+        }
+      }
+    }
+  }
+
+  check(idioms.size() > 0, "no fused idioms found");
+
+  for (const std::vector<uint8_t> &idiom : idioms) {
+    check_idiom(machine, idiom, random);
+  }
+
+  std::cout << "fusion: " << idioms.size() << " idioms checked" << std::endl;
+
+  return finish_checks("fusion");
+}
@@ -2,39 +2,69 @@
 #define _H_GP_MEMORY
 
 #include "address.h"
+#include <array>
+#include <cstdint>
 #include <iostream>
 #include <stddef.h>
-#include <vector>
 
 /**
- * Default address of the memory mapped output print device.
+ * Size of the memory, the whole 16-bit address space of the CPU.
  */
-constexpr size_t DEFAULT_OUTPUT_ADDRESS = 0xFFFB;
+constexpr size_t MEMORY_SIZE = 0x10000;
+
+/**
+ * Size of one memory page. The @ref Bus maps memory and devices per page.
+ */
+constexpr size_t PAGE_SIZE = 0x100;
+constexpr size_t PAGE_COUNT = MEMORY_SIZE / PAGE_SIZE;
+
+/// The page an address belongs to.
+constexpr size_t page_of(address addr) { return addr.inner() / PAGE_SIZE; }
 
 /**
  * Class that represents general purpose random access memory that could be used
  * by the emulated CPU.
+ *
+ * The memory always spans the whole address space. The CPU does not access it
+ * directly, but through a @ref Bus that maps it (or parts of it) into the
+ * address space.
  */
 class GP_Memory {
 private:
-  std::vector<std::byte> memory_;
-
-  address print_device_addr_;
+  alignas(64) std::array<std::byte, MEMORY_SIZE> memory_{};
 
 public:
-  GP_Memory() : memory_(), print_device_addr_(DEFAULT_OUTPUT_ADDRESS) {}
+  /**
+   * Get the size of the memory, which is always @ref MEMORY_SIZE.
+   */
+  static constexpr size_t size() { return MEMORY_SIZE; }
+
+  /**
+   * Read a raw address from the memory. The address wraps around the end of
+   * the address space.
+   *
+   * @param address The address to read.
+   * @return std::byte The byte at the address.
+   */
+  std::byte read(size_t address) const {
+    return memory_[address % MEMORY_SIZE];
+  }
 
-  size_t size() const;
+  /**
+   * Write a value to an address in the memory, bypassing any device.
+   *
+   * @param address The address to write to.
+   * @param value The value to write.
+   */
+  void write(address address, std::byte value) {
+    memory_[address.inner()] = value;
+  }
 
-  std::byte read(address address) const;
-  std::byte read(size_t address) const;
-  void write(address address, std::byte value);
+  std::byte *data() { return memory_.data(); }
+  const std::byte *data() const { return memory_.data(); }
 
   void import(std::istream &s);
   void import(const std::string &filename);
-
-  void set_print_device(address addr) { print_device_addr_ = addr; }
-  address print_device_addr() const { return print_device_addr_; }
 };
 
 #endif
@@ -0,0 +1,32 @@
+#include "hooks.h"
+#include "6502cpu.h"
+#include "6502isa.h"
+#include "address.h"
+
+#include <cstddef>
+#include <ios>
+
+void print_instruction(std::ostream &stream, std::byte opcode, address pc) {
+  const Instruction &instruction = isa[std::to_integer<size_t>(opcode)];
+
+  std::ios_base::fmtflags flags = stream.flags();
+
+  stream << "INSTRUCTION: " << instruction.name() << " ("
+         << std::to_integer<size_t>(opcode) << ")" << std::endl
+         << "  PC: " << std::hex << static_cast<int>(pc.inner()) << std::endl;
+
+  stream.flags(flags);
+}
+
+void print_interrupt(std::ostream &stream, address vector) {
+  stream << "INTERRUPT: " << (vector.inner() == NMI_VECTOR ? "NMI" : "IRQ")
+         << std::endl;
+}
+
+void TraceHooks::before_instruction(const CPU6502 &cpu, std::byte opcode) {
+  print_instruction(*stream_, opcode, cpu.get_PC());
+}
+
+void TraceHooks::interrupt_entry(const CPU6502 &cpu, address vector) {
+  print_interrupt(*stream_, vector);
+}
@@ -0,0 +1,83 @@
+#ifndef _H_HOOKS
+#define _H_HOOKS
+
+#include "address.h"
+#include "instruction_types.h"
+
+#include <cstddef>
+#include <iostream>
+#include <ostream>
+
+class CPU6502;
+
+/**
+ * Probes on a running CPU (see @ref CPU6502::set_hooks), e.g. for counting,
+ * tracing or coverage. Every hook does nothing by default, so a probe only
+ * overrides the ones it needs.
+ *
+ * A CPU without hooks runs loops that have no calls to them at all: setting
+ * hooks selects a loop of its own (see @ref RunPolicy), which always runs on
+ * the stepper. Memory accesses are reported by the bus, which sends all of
+ * them through its slow path while hooks are set (see @ref Bus::set_hooks).
+ *
+ * The runs of an idle loop the CPU skips (see
+ * @ref CPU6502::skipped_instructions) are not reported.
+ */
+class ExecutionHooks {
+public:
+  virtual ~ExecutionHooks() = default;
+
+  /**
+   * Called before an instruction runs, with the program counter at its
+   * opcode and its cycles not counted yet.
+   */
+  virtual void before_instruction(const CPU6502 &cpu, std::byte opcode) {}
+
+  /**
+   * Called after an instruction ran.
+   *
+   * @param err The result of the instruction.
+   */
+  virtual void after_instruction(const CPU6502 &cpu, std::byte opcode,
+                                 InstructionErr err) {}
+
+  /**
+   * Called after a read of data from memory or a device. Instruction fetches
+   * are not reported.
+   */
+  virtual void memory_read(address addr, std::byte value) {}
+
+  /// Called after a write to memory or a device, even one ignored by ROM.
+  virtual void memory_write(address addr, std::byte value) {}
+
+  /**
+   * Called when the CPU takes an IRQ or NMI, before it pushes the program
+   * counter and the status register and enters the handler.
+   *
+   * @param vector The vector the handler is loaded from.
+   */
+  virtual void interrupt_entry(const CPU6502 &cpu, address vector) {}
+};
+
+/// Print an instruction like verbose mode does, see @ref TraceHooks.
+void print_instruction(std::ostream &stream, std::byte opcode, address pc);
+
+/// Print an interrupt like verbose mode does, see @ref TraceHooks.
+void print_interrupt(std::ostream &stream, address vector);
+
+/**
+ * Prints every instruction and interrupt, the output of verbose mode (see
+ * @ref CPU6502::set_verbose).
+ */
+class TraceHooks : public ExecutionHooks {
+private:
+  std::ostream *stream_;
+
+public:
+  explicit TraceHooks(std::ostream &stream = std::cout) : stream_(&stream) {}
+
+  void before_instruction(const CPU6502 &cpu, std::byte opcode) override;
+  void interrupt_entry(const CPU6502 &cpu, address vector) override;
+};
+
+#endif
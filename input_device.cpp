@@ -0,0 +1,240 @@
+#include "input_device.h"
+#include "bus.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <format>
+#include <span>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define INPUT_DEVICE_POSIX 1
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+InputDevice::InputDevice(address data_address, int fd,
+                         InterruptController *interrupts)
+    : data_address_(data_address), fd_(fd), owns_fd_(false),
+      interrupts_(interrupts) {
+  if (interrupts_ != nullptr) {
+    irq_source_ = interrupts_->add_source();
+  }
+
+#ifdef INPUT_DEVICE_POSIX
+  if (pipe(stop_pipe_) != 0) {
+    throw std::runtime_error("Could not start reading the input.");
+  }
+#endif
+
+  thread_ = std::thread([this]() { read_input(); });
+}
+
+/**
+ * Open @p filename for reading.
+ */
+static int open_input(const std::string &filename) {
+#ifdef INPUT_DEVICE_POSIX
+  int fd = open(filename.c_str(), O_RDONLY);
+#else
+  int fd = -1;
+#endif
+
+  if (fd < 0) {
+    throw std::runtime_error(
+        std::format("Could not open input file {}.", filename));
+  }
+
+  return fd;
+}
+
+InputDevice::InputDevice(address data_address, const std::string &filename,
+                         InterruptController *interrupts)
+    : InputDevice(data_address, open_input(filename), interrupts) {
+  owns_fd_ = true;
+}
+
+InputDevice::~InputDevice() {
+  stop_.store(true, std::memory_order_release);
+  wake_up();
+
+#ifdef INPUT_DEVICE_POSIX
+  // wake the thread up if it is waiting for input
+  char stop = 0;
+
+  if (::write(stop_pipe_[1], &stop, 1) != 1) {
+    std::perror("input device");
+  }
+#endif
+
+  thread_.join();
+
+#ifdef INPUT_DEVICE_POSIX
+  close(stop_pipe_[0]);
+  close(stop_pipe_[1]);
+
+  if (owns_fd_) {
+    close(fd_);
+  }
+#endif
+}
+
+void InputDevice::wake_up() {
+  wakeups_.fetch_add(1, std::memory_order_release);
+  wakeups_.notify_one();
+}
+
+/**
+ * The reader thread: read the input into the ring as long as there is room in
+ * it, sleep while it is full.
+ */
+void InputDevice::read_input() {
+#ifdef INPUT_DEVICE_POSIX
+  std::array<char, 512> chunk;
+
+  while (!stop_.load(std::memory_order_acquire)) {
+    uint32_t wakeups = wakeups_.load(std::memory_order_acquire);
+    size_t room = ring_.capacity() - ring_.size();
+
+    if (room == 0) {
+      // returns right away if the CPU has made room since the load
+      wakeups_.wait(wakeups, std::memory_order_acquire);
+
+      continue;
+    }
+
+    pollfd fds[2] = {{fd_, POLLIN, 0}, {stop_pipe_[0], POLLIN, 0}};
+
+    if (poll(fds, 2, -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      break;
+    }
+
+    if (fds[1].revents != 0) {
+      return;
+    }
+
+    ssize_t count = ::read(fd_, chunk.data(), std::min(room, chunk.size()));
+
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+
+    if (count <= 0) {
+      break;
+    }
+
+    // the room in the ring only grows in the meantime
+    ring_.push(std::span(chunk.data(), static_cast<size_t>(count)));
+    update_irq();
+  }
+#endif
+
+  // without POSIX, there is no input
+
+  end_.store(true, std::memory_order_release);
+  update_irq();
+}
+
+bool InputDevice::irq_level() const {
+  return irq_enabled_.load(std::memory_order_acquire) &&
+         status() != std::byte{0};
+}
+
+/**
+ * Set the IRQ line to the status. Both threads change the status, so the line
+ * is set again if the status changed meanwhile; the last one to set the line
+ * then sees the final status.
+ */
+void InputDevice::update_irq() {
+  if (interrupts_ == nullptr) {
+    return;
+  }
+
+  bool level;
+
+  do {
+    level = irq_level();
+    interrupts_->set_irq(irq_source_, level);
+  } while (level != irq_level());
+}
+
+std::byte InputDevice::status() const {
+  // once the input has ended, the ring holds all that is left of it
+  bool end = end_.load(std::memory_order_acquire);
+  std::byte status{};
+
+  if (ring_.size() > 0) {
+    status |= INPUT_READY;
+  } else if (end) {
+    status |= INPUT_END;
+  }
+
+  return status;
+}
+
+/**
+ * The program found no input and waits for it, so show it what the program
+ * has printed so far. Cheap when there is nothing to write out.
+ */
+void InputDevice::waiting_for_input() {
+  if (bus_ != nullptr) {
+    bus_->stopped();
+  }
+}
+
+std::byte InputDevice::read(address addr) {
+  if (addr != data_address_) {
+    std::byte status = this->status();
+
+    if (status == std::byte{0}) {
+      waiting_for_input();
+    }
+
+    return status;
+  }
+
+  std::span<const char> input = ring_.peek();
+
+  if (input.empty()) {
+    waiting_for_input();
+
+    return std::byte{0};
+  }
+
+  auto value = static_cast<std::byte>(input.front());
+
+  ring_.consume(1);
+
+  // the reader thread may be waiting for room, this is cheap if it is not
+  wake_up();
+  update_irq();
+
+  return value;
+}
+
+std::byte InputDevice::peek(address addr) {
+  if (addr != data_address_) {
+    return status();
+  }
+
+  std::span<const char> input = ring_.peek();
+
+  return input.empty() ? std::byte{0} : static_cast<std::byte>(input.front());
+}
+
+void InputDevice::write(address addr, std::byte value) {
+  if (addr == data_address_) {
+    return;
+  }
+
+  irq_enabled_.store((value & INPUT_IRQ_ENABLE) != std::byte{0},
+                     std::memory_order_release);
+  update_irq();
+}
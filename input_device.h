@@ -0,0 +1,138 @@
+#ifndef _H_INPUT_DEVICE
+#define _H_INPUT_DEVICE
+
+#include "address.h"
+#include "device.h"
+#include "interrupt_controller.h"
+#include "spsc_ring.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+class Bus;
+
+/**
+ * Default address of the data register of the input device, the status
+ * register follows it.
+ */
+constexpr uint16_t DEFAULT_INPUT_ADDRESS = 0xFFF0;
+
+/**
+ * Size of the ring between the reader thread and the CPU.
+ */
+constexpr size_t INPUT_RING_SIZE = 4096;
+
+/// Status bit: a byte can be read from the data register.
+constexpr std::byte INPUT_READY{0x80};
+/// Status bit: the input has ended and everything has been read.
+constexpr std::byte INPUT_END{0x40};
+/// Bit written to the status register: assert IRQ while a status bit is set.
+constexpr std::byte INPUT_IRQ_ENABLE{0x80};
+
+/**
+ * A device that reads bytes from a file or the standard input.
+ *
+ * It has two registers: reading the data register (the first address) takes
+ * the next byte of the input, or returns 0 if there is none yet. The status
+ * register (the second address) has @ref INPUT_READY set while there are
+ * bytes to read and @ref INPUT_END once the input has ended and all of it has
+ * been read, so `BIT` puts them into the N and V flags.
+ *
+ * Writing @ref INPUT_IRQ_ENABLE to the status register makes the device
+ * assert IRQ for as long as a status bit is set, if it has an IRQ line;
+ * writing 0 turns that off again. Writes to the data register are ignored.
+ *
+ * The input is read by a thread of its own into an @ref SpscRing, so polling
+ * the status register is a couple of loads, not a system call.
+ *
+ * A program that finds no input waits for it, so the device then writes out
+ * the output of the devices on its bus (see @ref set_bus), like a prompt
+ * printed without a newline.
+ */
+class InputDevice : public Device {
+private:
+  SpscRing<INPUT_RING_SIZE> ring_;
+
+  address data_address_;
+
+  int fd_;
+  bool owns_fd_;
+
+  /// Set by the reader thread when the input has ended.
+  std::atomic<bool> end_{false};
+  /// Bumped by the CPU when it makes room in a full ring, and on stop.
+  std::atomic<uint32_t> wakeups_{0};
+  std::atomic<bool> stop_{false};
+  /// Wakes the reader thread up from waiting for input, see the destructor.
+  int stop_pipe_[2] = {-1, -1};
+
+  /// Whose output is written out while the program waits for input.
+  Bus *bus_ = nullptr;
+
+  InterruptController *interrupts_ = nullptr;
+  unsigned irq_source_ = 0;
+  std::atomic<bool> irq_enabled_{false};
+
+  std::thread thread_;
+
+  void wake_up();
+  void read_input();
+  bool irq_level() const;
+  void update_irq();
+  void waiting_for_input();
+
+public:
+  /**
+   * Read the input from @p fd, which has to stay open until the device is
+   * destroyed.
+   *
+   * @param data_address The address of the data register.
+   * @param interrupts The IRQ line of the device, if any. Has to outlive the
+   * device.
+   * @throws std::runtime_error If the controller has no IRQ source left.
+   */
+  InputDevice(address data_address, int fd,
+              InterruptController *interrupts = nullptr);
+
+  /**
+   * Read the input from the file @p filename.
+   *
+   * @param data_address The address of the data register.
+   * @param interrupts The IRQ line of the device, if any. Has to outlive the
+   * device.
+   * @throws std::runtime_error If the file cannot be opened or the controller
+   * has no IRQ source left.
+   */
+  InputDevice(address data_address, const std::string &filename,
+              InterruptController *interrupts = nullptr);
+
+  /// Stop the reader thread, whatever it has not read yet is dropped.
+  ~InputDevice() override;
+
+  InputDevice(const InputDevice &) = delete;
+  InputDevice &operator=(const InputDevice &) = delete;
+
+  /// The address of the data register, the status register is the next one.
+  address data_address() const { return data_address_; }
+  address status_address() const {
+    return address(static_cast<uint16_t>(data_address_.inner() + 1));
+  }
+
+  /**
+   * Write out the output of the devices on @p bus whenever the program finds
+   * no input, see @ref Bus::stopped. The bus has to outlive the device.
+   */
+  void set_bus(Bus *bus) { bus_ = bus; }
+
+  std::byte status() const;
+
+  std::byte read(address addr) override;
+  void write(address addr, std::byte value) override;
+  /// Like @ref read, but leaves the byte in the data register.
+  std::byte peek(address addr) override;
+};
+
+#endif
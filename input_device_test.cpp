@@ -0,0 +1,62 @@
+#include "input_device.h"
+#include "address.h"
+#include "print_device.h"
+#include "scheduler.h"
+#include "unit_test.h"
+
+#include <cstdint>
+#include <format>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+constexpr uint16_t INPUT = DEFAULT_INPUT_ADDRESS;
+constexpr uint16_t OUTPUT = DEFAULT_OUTPUT_ADDRESS;
+
+/**
+ * A program that prints a prompt without a newline and then polls for input
+ * that does not come sees the prompt written out while it waits, not only
+ * when the CPU stops.
+ */
+static void check_prompt() {
+  int input[2];
+
+  if (!check(pipe(input) == 0, "prompt: could not create a pipe")) {
+    return;
+  }
+
+  {
+    ScheduledMachine machine;
+    std::ostringstream stream;
+    PrintDevice printer(stream);
+    InputDevice reader(address(INPUT), input[0]);
+
+    machine.bus.map_device(address(OUTPUT), address(OUTPUT), &printer);
+    machine.bus.map_device(reader.data_address(), reader.status_address(),
+                           &reader);
+    reader.set_bus(&machine.bus);
+
+    // print the prompt, then poll the status register until there is input
+    machine.load(TEST_CODE, {0xA9, '>',                            // LDA #'>'
+                             0x8D, OUTPUT & 0xFF, OUTPUT >> 8,     // STA
+                             0x2C, (INPUT + 1) & 0xFF, INPUT >> 8, // BIT
+                             0x10, 0xFB});                         // BPL
+
+    std::string waiting;
+    machine.scheduler.schedule(1000, [&](uint64_t) { waiting = stream.str(); });
+    machine.cpu.run_for_cycles(2000);
+
+    check(waiting == ">",
+          std::format("prompt: \"{}\" written while waiting, expected \">\"",
+                      waiting));
+  }
+
+  close(input[0]);
+  close(input[1]);
+}
+
+int main() {
+  check_prompt();
+
+  return finish_checks("input_device");
+}
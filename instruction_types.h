@@ -2,12 +2,15 @@
 #define _H_INSTRUCTION_TYPES
 
 #include "address.h"
-#include <functional>
-#include <string>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
 
 class CPU6502;
 
-enum class AddressingMode {
+enum class AddressingMode : uint8_t {
   Absolute,
   AbsoluteIndexedIndirect,
   AbsoluteIndexedX,
@@ -23,15 +26,18 @@ enum class AddressingMode {
   ZeroPageIndexedX,
   ZeroPageIndexedY,
   ZeroPageIndirect,
-  ZeroPageIndirectIndexedY
+  ZeroPageIndirectIndexedY,
+  ZeroPageRelative
 };
 
-static size_t bytes_for_addressing_mode(AddressingMode mode) {
+constexpr size_t bytes_for_addressing_mode(AddressingMode mode) {
   switch (mode) {
   case AddressingMode::Absolute:
   case AddressingMode::AbsoluteIndexedX:
   case AddressingMode::AbsoluteIndexedY:
   case AddressingMode::AbsoluteIndirect:
+  case AddressingMode::AbsoluteIndexedIndirect:
+  case AddressingMode::ZeroPageRelative:
     return 3;
   case AddressingMode::Immediate:
   case AddressingMode::PCRelative:
@@ -42,7 +48,6 @@ static size_t bytes_for_addressing_mode(AddressingMode mode) {
   case AddressingMode::ZeroPageIndirect:
   case AddressingMode::ZeroPageIndirectIndexedY:
     return 2;
-  case AddressingMode::AbsoluteIndexedIndirect:
   case AddressingMode::Accumulator:
   case AddressingMode::Implied:
   case AddressingMode::Stack:
@@ -58,28 +63,80 @@ enum class InstructionErr {
   SIRaised,
   UnknownInstruction,
   GoToDebugger,
-  Stop
+  Stop,
+  /// The run reached its cycle limit, see @ref CPU6502::run_for_cycles.
+  CycleLimit,
+  /// The host asked the CPU to stop, see @ref StopReason::StopRequest.
+  StopRequested
 };
 
+/**
+ * Names of all instructions specified in the ABI (or datasheet). An
+ * @ref Instruction refers to its name by an index into this table.
+ */
+constexpr std::array<const char *, 99> MNEMONICS = {
+    "ADC", "AND", "ASL", "BBR0", "BBR1", "BBR2", "BBR3", "BBR4", "BBR5", "BBR6",
+    "BBR7", "BBS0", "BBS1", "BBS2", "BBS3", "BBS4", "BBS5", "BBS6", "BBS7",
+    "BCC", "BCS", "BEQ", "BIT", "BMI", "BNE", "BPL", "BRA", "BRK", "BVC", "BVS",
+    "CLC", "CLD", "CLI", "CLV", "CMP", "CPX", "CPY", "DBG", "DEC", "DEX", "DEY",
+    "EOR", "INC", "INX", "INY", "JMP", "JSR", "LDA", "LDX", "LDY", "LSR", "NOP",
+    "ORA", "PHA", "PHP", "PHX", "PHY", "PLA", "PLP", "PLX", "PLY", "RMB0",
+    "RMB1", "RMB2", "RMB3", "RMB4", "RMB5", "RMB6", "RMB7", "ROL", "ROR", "RTI",
+    "RTS", "SBC", "SEC", "SED", "SEI", "SMB0", "SMB1", "SMB2", "SMB3", "SMB4",
+    "SMB5", "SMB6", "SMB7", "STA", "STP", "STX", "STY", "STZ", "TAX", "TAY",
+    "TRB", "TSB", "TSX", "TXA", "TXS", "TYA", "WAI"};
+
+/**
+ * Find the index of @p name in @ref MNEMONICS.
+ *
+ * Only meant to be evaluated at compile time, an unknown name fails the build.
+ */
+constexpr uint8_t mnemonic_index(const char *name) {
+  for (size_t i = 0; i < MNEMONICS.size(); ++i) {
+    if (std::string_view(MNEMONICS[i]) == name) {
+      return static_cast<uint8_t>(i);
+    }
+  }
+
+  throw std::invalid_argument("Unknown instruction name.");
+}
+
+/// The function to execute an instruction. Accepts the CPU from which it
+/// gets context from and the resolved operand address.
+using InstructionHandler = InstructionErr (*)(CPU6502 &, address);
+
+/**
+ * One entry of the instruction set. Kept at two words so that the whole table
+ * takes 4 KiB; the name lives in the static @ref MNEMONICS table.
+ */
 struct Instruction {
 
-  /// The name of the instruction specified in the ABI (or datasheet).
-  std::string name;
+  /// The function to execute the instruction, `nullptr` for unknown opcodes.
+  InstructionHandler execute = nullptr;
+  /// Index of the name of the instruction in @ref MNEMONICS.
+  uint8_t mnemonic = 0;
   /// The addressing mode of the instruction.
-  AddressingMode mode;
+  AddressingMode mode = AddressingMode::Implied;
   /// The number of bytes the instruction takes up in memory.
-  size_t bytes;
-  /// The function to execute the instruction. Accepts the CPU from which it
-  /// gets context from.
-  std::function<InstructionErr(CPU6502 &, address)> execute;
-
-  Instruction(std::string name_, AddressingMode mode_,
-              std::function<InstructionErr(CPU6502 &, address)> execute_) {
-    name = name_;
-    mode = mode_;
-    bytes = bytes_for_addressing_mode(mode);
-    execute = execute_;
-  };
+  uint8_t bytes = 0;
+  /// The base number of cycles the instruction takes, as listed in the manual.
+  uint8_t cycles = 0;
+
+  constexpr Instruction() = default;
+
+  constexpr Instruction(const char *name_, AddressingMode mode_,
+                        uint8_t cycles_, InstructionHandler execute_)
+      : execute(execute_), mnemonic(mnemonic_index(name_)), mode(mode_),
+        bytes(static_cast<uint8_t>(bytes_for_addressing_mode(mode_))),
+        cycles(cycles_) {}
+
+  /// The name of the instruction specified in the ABI (or datasheet).
+  constexpr const char *name() const { return MNEMONICS[mnemonic]; }
+
+  /// Is there an instruction behind this opcode?
+  constexpr bool valid() const { return execute != nullptr; }
 };
 
+static_assert(sizeof(Instruction) <= 2 * sizeof(void *));
+
 #endif
@@ -0,0 +1,103 @@
+#ifndef _H_INTERRUPT_CONTROLLER
+#define _H_INTERRUPT_CONTROLLER
+
+#include <atomic>
+#include <cstdint>
+#include <stdexcept>
+
+/// Bit of the pending word for a latched NMI.
+constexpr uint32_t NMI_PENDING = 1u << 31;
+/// Bit of the pending word for a request to stop the run.
+constexpr uint32_t STOP_PENDING = 1u << 30;
+/// Bits of the pending word for the IRQ sources, one per source.
+constexpr uint32_t IRQ_PENDING = ~(NMI_PENDING | STOP_PENDING);
+/// Number of devices that can share the IRQ line.
+constexpr unsigned IRQ_SOURCES = 30;
+
+/**
+ * The IRQ and NMI lines of the CPU.
+ *
+ * Both lines live in one pending word, so the CPU only has to check that it
+ * is zero between instructions. Every source has its own IRQ bit and keeps it
+ * set for as long as it asserts the line (IRQ is level-triggered); an NMI is
+ * latched until the CPU takes it (NMI is edge-triggered).
+ *
+ * The host can ask the CPU to stop running through the same word (see
+ * @ref request_stop), so that costs the CPU nothing either.
+ *
+ * Devices may raise and release the lines from any thread. A CPU waiting in
+ * `WAI` sleeps until the word is no longer zero.
+ */
+class InterruptController {
+private:
+  std::atomic<uint32_t> pending_{0};
+
+  unsigned sources_ = 0;
+
+public:
+  InterruptController() = default;
+
+  InterruptController(const InterruptController &) = delete;
+  InterruptController &operator=(const InterruptController &) = delete;
+
+  /// The combined pending word, see @ref NMI_PENDING and @ref IRQ_PENDING.
+  const std::atomic<uint32_t> &pending() const { return pending_; }
+
+  /**
+   * Reserve an IRQ bit for a new source.
+   *
+   * @throws std::runtime_error If all @ref IRQ_SOURCES bits are taken.
+   */
+  unsigned add_source() {
+    if (sources_ == IRQ_SOURCES) {
+      throw std::runtime_error("Too many interrupt sources.");
+    }
+
+    return sources_++;
+  }
+
+  /**
+   * Assert or release the IRQ line for @p source, see @ref add_source.
+   */
+  void set_irq(unsigned source, bool asserted) {
+    uint32_t bit = 1u << source;
+
+    if (asserted) {
+      if ((pending_.fetch_or(bit, std::memory_order_acq_rel) & bit) == 0) {
+        pending_.notify_all();
+      }
+    } else {
+      pending_.fetch_and(~bit, std::memory_order_acq_rel);
+    }
+  }
+
+  /// Latch an NMI, it is taken before the next instruction.
+  void raise_nmi() {
+    pending_.fetch_or(NMI_PENDING, std::memory_order_acq_rel);
+    pending_.notify_all();
+  }
+
+  /// Clear the latched NMI as the CPU takes it.
+  bool take_nmi() {
+    return (pending_.fetch_and(~NMI_PENDING, std::memory_order_acq_rel) &
+            NMI_PENDING) != 0;
+  }
+
+  /**
+   * Ask the CPU to stop at the next instruction (or block) boundary, its run
+   * then returns @ref StopReason::StopRequest. Wakes up a CPU waiting in
+   * `WAI`, which stays on `WAI`.
+   */
+  void request_stop() {
+    pending_.fetch_or(STOP_PENDING, std::memory_order_acq_rel);
+    pending_.notify_all();
+  }
+
+  /// Clear the stop request as the CPU takes it.
+  bool take_stop() {
+    return (pending_.fetch_and(~STOP_PENDING, std::memory_order_acq_rel) &
+            STOP_PENDING) != 0;
+  }
+};
+
+#endif
@@ -0,0 +1,1010 @@
+#include "jit.h"
+#include "6502cpu.h"
+#include "6502isa.h"
+#include "address.h"
+#include "block_cache.h"
+#include "bus.h"
+#include "gp_memory.h"
+#include "instruction_types.h"
+#include "psr.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X86_64 1
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// the compiled code passes these in registers and relies on their values
+static_assert(static_cast<int>(InstructionErr::OK) == 0);
+static_assert(static_cast<int>(InstructionErr::OKPCModified) == 1);
+static_assert(sizeof(bool) == 1 && sizeof(address) == 2);
+static_assert(std::is_standard_layout_v<CPU6502>);
+static_assert(std::is_standard_layout_v<Bus>);
+
+constexpr uint8_t FLAG_I = 1 << static_cast<int>(psr_bit::interrupt_disable);
+constexpr uint8_t FLAG_D = 1 << static_cast<int>(psr_bit::decimal_mode);
+
+/**
+ * Called by the compiled code for stores that take the slow path of
+ * @ref Bus::write.
+ *
+ * @return Whether the store overwrote decoded code.
+ */
+uint32_t jit_write(Bus *bus, uint32_t target, uint32_t value) {
+  uint64_t code_version = bus->code_version();
+
+  bus->write(address(target), std::byte(value));
+
+  return bus->code_version() != code_version;
+}
+
+enum Register : uint8_t {
+  RAX,
+  RCX,
+  RDX,
+  RBX,
+  RSP,
+  RBP,
+  RSI,
+  RDI,
+  R8,
+  R9,
+  R10,
+  R11,
+  R12,
+  R13,
+  R14,
+  R15
+};
+
+enum Condition : uint8_t { CC_AE = 0x3, CC_E = 0x4, CC_NE = 0x5 };
+
+/// Extensions of the 0x80 (ALU r/m8, imm8) and 0x81 (ALU r/m, imm32) opcodes.
+enum AluExtension : uint8_t {
+  ALU_ADD = 0,
+  ALU_OR = 1,
+  ALU_AND = 4,
+  ALU_SUB = 5
+};
+
+/// Opcodes of the ALU r/m8, r8 instructions.
+enum AluOpcode : uint8_t {
+  ALU_OR_RR = 0x08,
+  ALU_AND_RR = 0x20,
+  ALU_SUB_RR = 0x28,
+  ALU_XOR_RR = 0x30
+};
+
+/**
+ * Encoder for the handful of x86-64 instructions the compiler needs.
+ *
+ * Byte registers are limited to AL, CL and DL, memory operands are always
+ * `[base + disp32]`.
+ */
+class Assembler {
+private:
+  std::vector<uint8_t> code_;
+
+  void rex(bool wide, uint8_t reg, uint8_t base) {
+    uint8_t value = static_cast<uint8_t>(0x40 | (wide ? 0x08 : 0) |
+                                         ((reg & 8) >> 1) | ((base & 8) >> 3));
+
+    if (value != 0x40) {
+      byte(value);
+    }
+  }
+
+  void modrm(uint8_t mod, uint8_t reg, uint8_t rm) {
+    byte(static_cast<uint8_t>(mod << 6 | (reg & 7) << 3 | (rm & 7)));
+  }
+
+  void memory(uint8_t reg, uint8_t base, uint32_t disp) {
+    modrm(2, reg, base);
+
+    if ((base & 7) == RSP) {
+      byte(0x24);
+    }
+
+    dword(disp);
+  }
+
+public:
+  const std::vector<uint8_t> &code() const { return code_; }
+  size_t size() const { return code_.size(); }
+
+  void byte(uint8_t value) { code_.push_back(value); }
+
+  void word(uint16_t value) {
+    byte(static_cast<uint8_t>(value));
+    byte(static_cast<uint8_t>(value >> 8));
+  }
+
+  void dword(uint32_t value) {
+    word(static_cast<uint16_t>(value));
+    word(static_cast<uint16_t>(value >> 16));
+  }
+
+  void qword(uint64_t value) {
+    dword(static_cast<uint32_t>(value));
+    dword(static_cast<uint32_t>(value >> 32));
+  }
+
+  /// movzx dst32, byte [base + disp]
+  void load8(uint8_t dst, uint8_t base, uint32_t disp) {
+    rex(false, dst, base);
+    byte(0x0F);
+    byte(0xB6);
+    memory(dst, base, disp);
+  }
+
+  /// mov byte [base + disp], src8
+  void store8(uint8_t base, uint32_t disp, uint8_t src) {
+    rex(false, src, base);
+    byte(0x88);
+    memory(src, base, disp);
+  }
+
+  /// mov byte [base + disp], imm8
+  void store8_immediate(uint8_t base, uint32_t disp, uint8_t value) {
+    rex(false, 0, base);
+    byte(0xC6);
+    memory(0, base, disp);
+    byte(value);
+  }
+
+  /// mov word [base + disp], imm16
+  void store16(uint8_t base, uint32_t disp, uint16_t value) {
+    byte(0x66);
+    rex(false, 0, base);
+    byte(0xC7);
+    memory(0, base, disp);
+    word(value);
+  }
+
+  /// add/or/and byte [base + disp], imm8
+  void alu8(AluExtension op, uint8_t base, uint32_t disp, uint8_t value) {
+    rex(false, 0, base);
+    byte(0x80);
+    memory(op, base, disp);
+    byte(value);
+  }
+
+  /// add/sub qword [base + disp], imm32
+  void alu64(AluExtension op, uint8_t base, uint32_t disp, uint32_t value) {
+    rex(true, 0, base);
+    byte(0x81);
+    memory(op, base, disp);
+    dword(value);
+  }
+
+  /// test byte [base + disp], imm8
+  void test8(uint8_t base, uint32_t disp, uint8_t value) {
+    rex(false, 0, base);
+    byte(0xF6);
+    memory(0, base, disp);
+    byte(value);
+  }
+
+  /// add/or/and reg8, imm8
+  void alu8(AluExtension op, uint8_t reg, uint8_t value) {
+    byte(0x80);
+    modrm(3, op, reg);
+    byte(value);
+  }
+
+  /// or/and/sub/xor dst8, src8
+  void alu8(AluOpcode op, uint8_t dst, uint8_t src) {
+    byte(op);
+    modrm(3, src, dst);
+  }
+
+  /// setcc reg8
+  void set(Condition condition, uint8_t reg) {
+    byte(0x0F);
+    byte(static_cast<uint8_t>(0x90 | condition));
+    modrm(3, 0, reg);
+  }
+
+  /// test reg32, reg32
+  void test32(uint8_t reg) {
+    byte(0x85);
+    modrm(3, reg, reg);
+  }
+
+  /// test reg64, reg64
+  void test64(uint8_t reg) {
+    rex(true, reg, reg);
+    byte(0x85);
+    modrm(3, reg, reg);
+  }
+
+  /// mov dst32, imm32
+  void move32(uint8_t dst, uint32_t value) {
+    rex(false, 0, dst);
+    byte(static_cast<uint8_t>(0xB8 | (dst & 7)));
+    dword(value);
+  }
+
+  /// mov dst64, imm64
+  void move64(uint8_t dst, uint64_t value) {
+    rex(true, 0, dst);
+    byte(static_cast<uint8_t>(0xB8 | (dst & 7)));
+    qword(value);
+  }
+
+  /// mov dst64, src64
+  void move(uint8_t dst, uint8_t src) {
+    rex(true, src, dst);
+    byte(0x89);
+    modrm(3, src, dst);
+  }
+
+  /// mov dst64, qword [base + disp]
+  void load64(uint8_t dst, uint8_t base, uint32_t disp) {
+    rex(true, dst, base);
+    byte(0x8B);
+    memory(dst, base, disp);
+  }
+
+  /// cmp a64, b64
+  void compare64(uint8_t a, uint8_t b) {
+    rex(true, b, a);
+    byte(0x39);
+    modrm(3, b, a);
+  }
+
+  /// call reg64
+  void call(uint8_t reg) {
+    rex(false, 0, reg);
+    byte(0xFF);
+    modrm(3, 2, reg);
+  }
+
+  void push(uint8_t reg) {
+    rex(false, 0, reg);
+    byte(static_cast<uint8_t>(0x50 | (reg & 7)));
+  }
+
+  void pop(uint8_t reg) {
+    rex(false, 0, reg);
+    byte(static_cast<uint8_t>(0x58 | (reg & 7)));
+  }
+
+  void ret() { byte(0xC3); }
+
+  /// jcc rel32, returns the position of the displacement for @ref patch.
+  size_t jump_if(Condition condition) {
+    byte(0x0F);
+    byte(static_cast<uint8_t>(0x80 | condition));
+    dword(0);
+
+    return size() - 4;
+  }
+
+  /// jmp rel32, returns the position of the displacement for @ref patch.
+  size_t jump() {
+    byte(0xE9);
+    dword(0);
+
+    return size() - 4;
+  }
+
+  /// Point the jump with its displacement at @p position to @p target.
+  void patch(size_t position, size_t target) {
+    uint32_t displacement = static_cast<uint32_t>(target - (position + 4));
+
+    std::memcpy(&code_[position], &displacement, sizeof(displacement));
+  }
+};
+
+} // namespace
+
+/**
+ * Translates one decoded block.
+ *
+ * Register use of the compiled code: RBX holds the CPU, R13 the contents of
+ * the RAM of the bus, R15 the bus, RBP the address of the code version of the
+ * bus and R12 its value when the block was entered.
+ *
+ * Reads of pages the bus maps to its RAM at compile time load straight from
+ * R13, so the mapping must not change while compiled code exists.
+ * The program counter is only stored before calls and when leaving the block,
+ * the cycles are counted there too.
+ */
+class Jit::Compiler {
+private:
+  static constexpr uint32_t A = offsetof(CPU6502, A);
+  static constexpr uint32_t X = offsetof(CPU6502, X);
+  static constexpr uint32_t Y = offsetof(CPU6502, Y);
+  static constexpr uint32_t S = offsetof(CPU6502, S);
+  static constexpr uint32_t P = offsetof(CPU6502, P) + offsetof(PSR, psr_);
+  static constexpr uint32_t N = offsetof(CPU6502, P) + offsetof(PSR, negative_);
+  static constexpr uint32_t Z = offsetof(CPU6502, P) + offsetof(PSR, zero_);
+  static constexpr uint32_t V = offsetof(CPU6502, P) + offsetof(PSR, overflow_);
+  static constexpr uint32_t C = offsetof(CPU6502, P) + offsetof(PSR, carry_);
+  static constexpr uint32_t PC = offsetof(CPU6502, PC);
+  static constexpr uint32_t COUNTDOWN = offsetof(CPU6502, event_countdown_);
+  static constexpr uint32_t WRITE_PAGES = offsetof(Bus, write_pages_);
+
+  const Bus &bus_;
+  Assembler assembler_;
+  /// Jumps to the epilogue, patched once its position is known.
+  std::vector<size_t> exits_;
+  /// Cycles of the instructions so far that are not counted by the code yet.
+  uint32_t cycles_ = 0;
+
+  /// Count the cycles of the instructions so far, see @ref cycles_.
+  void count_cycles() {
+    if (cycles_ != 0) {
+      assembler_.alu64(ALU_SUB, RBX, COUNTDOWN, cycles_);
+    }
+  }
+
+  void leave() { exits_.push_back(assembler_.jump()); }
+
+  void leave(uint16_t pc, InstructionErr err) {
+    count_cycles();
+    assembler_.store16(RBX, PC, pc);
+    assembler_.move32(RAX, static_cast<uint32_t>(err));
+    leave();
+  }
+
+  /// Update N and Z from AL.
+  void update_flags() {
+    assembler_.store8(RBX, N, RAX);
+    assembler_.store8(RBX, Z, RAX);
+  }
+
+  /**
+   * The address a zero page or absolute instruction reads, if the compiled
+   * code can read it straight from the memory.
+   */
+  std::optional<uint32_t> readable_address(const Instruction &instruction,
+                                           address operand) const {
+    uint32_t target;
+
+    if (instruction.mode == AddressingMode::ZeroPage) {
+      target = std::to_integer<uint32_t>(operand.low());
+    } else if (instruction.mode == AddressingMode::Absolute) {
+      target = operand.inner();
+    } else {
+      return std::nullopt;
+    }
+
+    // ROM and devices are read through the bus by the handler
+    const std::byte *storage = bus_.read_pages_[page_of(address(target))];
+
+    if (storage != bus_.ram() + (target & ~(PAGE_SIZE - 1))) {
+      return std::nullopt;
+    }
+
+    return target;
+  }
+
+  /// Load the operand of a read instruction into @p reg.
+  bool load_operand(const Instruction &instruction, address operand,
+                    uint8_t reg) {
+    if (instruction.mode == AddressingMode::Immediate) {
+      assembler_.move32(reg, std::to_integer<uint32_t>(operand.low()));
+
+      return true;
+    }
+
+    auto target = readable_address(instruction, operand);
+
+    if (!target) {
+      return false;
+    }
+
+    assembler_.load8(reg, R13, *target);
+
+    return true;
+  }
+
+  bool load(const Instruction &instruction, address operand, uint32_t reg) {
+    if (!load_operand(instruction, operand, RAX)) {
+      return false;
+    }
+
+    assembler_.store8(RBX, reg, RAX);
+    update_flags();
+
+    return true;
+  }
+
+  bool logic(const Instruction &instruction, address operand, AluOpcode op) {
+    if (!load_operand(instruction, operand, RCX)) {
+      return false;
+    }
+
+    assembler_.load8(RAX, RBX, A);
+    assembler_.alu8(op, RAX, RCX);
+    assembler_.store8(RBX, A, RAX);
+    update_flags();
+
+    return true;
+  }
+
+  bool compare(const Instruction &instruction, address operand, uint32_t reg) {
+    if (!load_operand(instruction, operand, RCX)) {
+      return false;
+    }
+
+    assembler_.load8(RAX, RBX, reg);
+    assembler_.alu8(ALU_SUB_RR, RAX, RCX);
+    assembler_.set(CC_AE, RDX);
+    assembler_.store8(RBX, C, RDX);
+    update_flags();
+
+    return true;
+  }
+
+  /// A store (of @p reg, or zero if there is none), leaves the block if it
+  /// overwrote decoded code.
+  bool store(const Instruction &instruction, address operand,
+             std::optional<uint32_t> reg, uint16_t next) {
+    uint32_t target;
+
+    if (instruction.mode == AddressingMode::ZeroPage) {
+      target = std::to_integer<uint32_t>(operand.low());
+    } else if (instruction.mode == AddressingMode::Absolute) {
+      target = operand.inner();
+    } else {
+      return false;
+    }
+
+    if (reg) {
+      assembler_.load8(RDX, RBX, *reg);
+    } else {
+      assembler_.move32(RDX, 0);
+    }
+
+    // like Bus::write, store through the write pointer of the page if it
+    // has one
+    uint32_t page = static_cast<uint32_t>(page_of(address(target)));
+
+    assembler_.load64(RAX, R15, WRITE_PAGES + page * sizeof(std::byte *));
+    assembler_.test64(RAX);
+    size_t slow = assembler_.jump_if(CC_E);
+    assembler_.store8(RAX, target % PAGE_SIZE, RDX);
+    size_t done = assembler_.jump();
+
+    // devices see the cycles up to here, the fast path counts them later
+    assembler_.patch(slow, assembler_.size());
+    count_cycles();
+    assembler_.move(RDI, R15);
+    assembler_.move32(RSI, target);
+    assembler_.move64(RAX, reinterpret_cast<uint64_t>(&jit_write));
+    assembler_.call(RAX);
+
+    if (cycles_ != 0) {
+      assembler_.alu64(ALU_ADD, RBX, COUNTDOWN, cycles_);
+    }
+
+    assembler_.test32(RAX);
+
+    size_t skip = assembler_.jump_if(CC_E);
+    leave(next, InstructionErr::OK);
+    assembler_.patch(skip, assembler_.size());
+    assembler_.patch(done, assembler_.size());
+
+    return true;
+  }
+
+  void transfer(uint32_t from, uint32_t to, bool flags) {
+    assembler_.load8(RAX, RBX, from);
+    assembler_.store8(RBX, to, RAX);
+
+    if (flags) {
+      update_flags();
+    }
+  }
+
+  void step(uint32_t reg, uint8_t delta) {
+    assembler_.load8(RAX, RBX, reg);
+    assembler_.alu8(ALU_ADD, RAX, delta);
+    assembler_.store8(RBX, reg, RAX);
+    update_flags();
+  }
+
+  /// Set or clear one of the I and D flags.
+  void flag(uint8_t mask, bool value) {
+    if (value) {
+      assembler_.alu8(ALU_OR, RBX, P, mask);
+    } else {
+      assembler_.alu8(ALU_AND, RBX, P, static_cast<uint8_t>(~mask));
+    }
+  }
+
+  /**
+   * Leave the block for @p target if the bits in @p mask of the byte at
+   * @p flag are non-zero (@p set) or zero (not @p set). A taken branch costs
+   * @p taken_cycles more than a branch that is not.
+   */
+  void branch(uint32_t flag, uint8_t mask, bool set, uint16_t target,
+              uint8_t taken_cycles) {
+    assembler_.test8(RBX, flag, mask);
+
+    size_t skip = assembler_.jump_if(set ? CC_E : CC_NE);
+    cycles_ += taken_cycles;
+    leave(target, InstructionErr::OKPCModified);
+    cycles_ -= taken_cycles;
+    assembler_.patch(skip, assembler_.size());
+  }
+
+  /// Call the handler of the instruction, like the interpreter does.
+  void call(const Instruction &instruction, address operand, uint16_t pc) {
+    count_cycles();
+    cycles_ = 0;
+
+    assembler_.store16(RBX, PC, pc);
+    assembler_.move(RDI, RBX);
+    assembler_.move32(RSI, operand.inner());
+    assembler_.move64(RAX, reinterpret_cast<uint64_t>(instruction.execute));
+    assembler_.call(RAX);
+
+    // anything but OK leaves with the result of the handler
+    assembler_.test32(RAX);
+    exits_.push_back(assembler_.jump_if(CC_NE));
+
+    // leave with OK if the handler overwrote decoded code
+    assembler_.load64(RCX, RBP, 0);
+    assembler_.compare64(RCX, R12);
+    exits_.push_back(assembler_.jump_if(CC_NE));
+  }
+
+  /**
+   * Translate one instruction to host code.
+   *
+   * @return Whether the instruction always leaves the block.
+   */
+  bool translate(const DecodedInstruction &decoded, uint16_t pc) {
+    const Instruction &instruction = isa[decoded.opcode];
+    address operand = decoded.operand;
+    uint16_t next = static_cast<uint16_t>(pc + decoded.bytes);
+    uint16_t target = static_cast<uint16_t>(
+        next + static_cast<int8_t>(std::to_integer<uint8_t>(operand.low())));
+
+    // the target of a relative branch is known, and so is its extra cycle
+    // for crossing a page
+    uint8_t page_cycles = crosses_page(address(next), address(target));
+
+    bool translated = true;
+
+    cycles_ += instruction.cycles;
+
+    switch (instruction.mnemonic) {
+    case mnemonic_index("LDA"):
+      translated = load(instruction, operand, A);
+      break;
+    case mnemonic_index("LDX"):
+      translated = load(instruction, operand, X);
+      break;
+    case mnemonic_index("LDY"):
+      translated = load(instruction, operand, Y);
+      break;
+    case mnemonic_index("STA"):
+      translated = store(instruction, operand, A, next);
+      break;
+    case mnemonic_index("STX"):
+      translated = store(instruction, operand, X, next);
+      break;
+    case mnemonic_index("STY"):
+      translated = store(instruction, operand, Y, next);
+      break;
+    case mnemonic_index("STZ"):
+      translated = store(instruction, operand, std::nullopt, next);
+      break;
+    case mnemonic_index("AND"):
+      translated = logic(instruction, operand, ALU_AND_RR);
+      break;
+    case mnemonic_index("ORA"):
+      translated = logic(instruction, operand, ALU_OR_RR);
+      break;
+    case mnemonic_index("EOR"):
+      translated = logic(instruction, operand, ALU_XOR_RR);
+      break;
+    case mnemonic_index("CMP"):
+      translated = compare(instruction, operand, A);
+      break;
+    case mnemonic_index("CPX"):
+      translated = compare(instruction, operand, X);
+      break;
+    case mnemonic_index("CPY"):
+      translated = compare(instruction, operand, Y);
+      break;
+    case mnemonic_index("TAX"):
+      transfer(A, X, true);
+      break;
+    case mnemonic_index("TAY"):
+      transfer(A, Y, true);
+      break;
+    case mnemonic_index("TXA"):
+      transfer(X, A, true);
+      break;
+    case mnemonic_index("TYA"):
+      transfer(Y, A, true);
+      break;
+    case mnemonic_index("TSX"):
+      transfer(S, X, true);
+      break;
+    case mnemonic_index("TXS"):
+      transfer(X, S, false);
+      break;
+    case mnemonic_index("INX"):
+      step(X, 1);
+      break;
+    case mnemonic_index("INY"):
+      step(Y, 1);
+      break;
+    case mnemonic_index("DEX"):
+      step(X, 0xFF);
+      break;
+    case mnemonic_index("DEY"):
+      step(Y, 0xFF);
+      break;
+    case mnemonic_index("CLC"):
+      assembler_.store8_immediate(RBX, C, 0);
+      break;
+    case mnemonic_index("SEC"):
+      assembler_.store8_immediate(RBX, C, 1);
+      break;
+    case mnemonic_index("CLI"):
+      flag(FLAG_I, false);
+      break;
+    case mnemonic_index("SEI"):
+      flag(FLAG_I, true);
+      break;
+    case mnemonic_index("CLD"):
+      flag(FLAG_D, false);
+      break;
+    case mnemonic_index("SED"):
+      flag(FLAG_D, true);
+      break;
+    case mnemonic_index("CLV"):
+      assembler_.store8_immediate(RBX, V, 0);
+      break;
+    case mnemonic_index("NOP"):
+      break;
+    case mnemonic_index("BPL"):
+      branch(N, 0x80, false, target, 1 + page_cycles);
+      break;
+    case mnemonic_index("BMI"):
+      branch(N, 0x80, true, target, 1 + page_cycles);
+      break;
+    case mnemonic_index("BVC"):
+      branch(V, 0x80, false, target, 1 + page_cycles);
+      break;
+    case mnemonic_index("BVS"):
+      branch(V, 0x80, true, target, 1 + page_cycles);
+      break;
+    case mnemonic_index("BCC"):
+      branch(C, 1, false, target, 1 + page_cycles);
+      break;
+    case mnemonic_index("BCS"):
+      branch(C, 1, true, target, 1 + page_cycles);
+      break;
+    // Z is set when its byte is zero
+    case mnemonic_index("BNE"):
+      branch(Z, 0xFF, true, target, 1 + page_cycles);
+      break;
+    case mnemonic_index("BEQ"):
+      branch(Z, 0xFF, false, target, 1 + page_cycles);
+      break;
+    case mnemonic_index("BRA"):
+      cycles_ += page_cycles;
+      leave(target, InstructionErr::OKPCModified);
+      return true;
+    case mnemonic_index("JMP"):
+      if (instruction.mode != AddressingMode::Absolute) {
+        translated = false;
+        break;
+      }
+
+      leave(operand.inner(), InstructionErr::OKPCModified);
+      return true;
+    default:
+      translated = false;
+      break;
+    }
+
+    if (!translated) {
+      call(instruction, operand, pc);
+    }
+
+    return false;
+  }
+
+public:
+  explicit Compiler(const Bus &bus) : bus_(bus) {}
+
+  const std::vector<uint8_t> &compile(const DecodedBlock &block,
+                                      address start) {
+    // five pushes keep the stack aligned to 16 bytes for the calls
+    assembler_.push(RBX);
+    assembler_.push(RBP);
+    assembler_.push(R12);
+    assembler_.push(R13);
+    assembler_.push(R15);
+
+    assembler_.move(RBX, RDI);
+    assembler_.move(R13, RSI);
+    assembler_.move(R15, RDX);
+    assembler_.move(RBP, RCX);
+    assembler_.load64(R12, RBP, 0);
+
+    uint16_t pc = start.inner();
+    bool left = false;
+
+    for (const DecodedInstruction &decoded : block.instructions) {
+      left = translate(decoded, pc);
+      pc = static_cast<uint16_t>(pc + decoded.bytes);
+    }
+
+    if (!left) {
+      leave(pc, InstructionErr::OK);
+    }
+
+    for (size_t exit : exits_) {
+      assembler_.patch(exit, assembler_.size());
+    }
+
+    assembler_.pop(R15);
+    assembler_.pop(R13);
+    assembler_.pop(R12);
+    assembler_.pop(RBP);
+    assembler_.pop(RBX);
+    assembler_.ret();
+
+    return assembler_.code();
+  }
+};
+
+Jit::Jit() {
+#ifdef JIT_X86_64
+  void *code = mmap(nullptr, JIT_CODE_SIZE, PROT_READ | PROT_EXEC,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (code != MAP_FAILED) {
+    code_ = static_cast<std::byte *>(code);
+  }
+#endif
+}
+
+Jit::~Jit() {
+#ifdef JIT_X86_64
+  if (code_ != nullptr) {
+    munmap(code_, JIT_CODE_SIZE);
+  }
+#endif
+}
+
+/**
+ * Can the host run compiled code?
+ */
+bool Jit::supported() {
+#ifdef JIT_X86_64
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * Compile @p block, which starts at @p start, and store its entry point in
+ * @ref DecodedBlock::native.
+ *
+ * If the code buffer is full, the host code of all blocks in @p cache is
+ * dropped first.
+ *
+ * @return Whether the block was compiled.
+ */
+bool Jit::compile(BlockCache &cache, DecodedBlock &block, address start,
+                  const Bus &bus) {
+#ifdef JIT_X86_64
+  if (code_ == nullptr) {
+    return false;
+  }
+
+  Compiler compiler(bus);
+  const std::vector<uint8_t> &code = compiler.compile(block, start);
+
+  if (code.size() > JIT_CODE_SIZE) {
+    return false;
+  }
+
+  if (code_used_ + code.size() > JIT_CODE_SIZE) {
+    cache.drop_native();
+    code_used_ = 0;
+  }
+
+  std::byte *entry = code_ + code_used_;
+
+  // only the pages the block goes to are made writable, and the buffer is
+  // never writable and executable at the same time
+  static const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  size_t first = code_used_ / page_size * page_size;
+  size_t end = (code_used_ + code.size() + page_size - 1) / page_size *
+               page_size;
+
+  if (mprotect(code_ + first, end - first, PROT_READ | PROT_WRITE) != 0) {
+    return false;
+  }
+
+  std::memcpy(entry, code.data(), code.size());
+  code_used_ += code.size();
+
+  if (mprotect(code_ + first, end - first, PROT_READ | PROT_EXEC) != 0) {
+    return false;
+  }
+
+  block.native = reinterpret_cast<NativeBlock>(entry);
+  ++compiled_blocks_;
+
+  return true;
+#else
+  (void)cache;
+  (void)block;
+  (void)start;
+  (void)bus;
+
+  return false;
+#endif
+}
+
+/**
+ * Run the compiled code of @p block, which has to start at the program
+ * counter. Returns like @ref CPU6502::run_block.
+ */
+InstructionErr Jit::execute(CPU6502 &cpu, const DecodedBlock &block) {
+  if (verify_) {
+    return execute_verified(cpu, block);
+  }
+
+  Bus *bus = cpu.bus_;
+
+  return block.native(&cpu, bus->ram(), bus, &bus->code_version_);
+}
+
+/**
+ * Run the compiled code of @p block, then roll the CPU, the bus and its RAM
+ * back, run the interpreter instead and compare the results.
+ *
+ * Devices only see the accesses of the compiled code: the interpreter gets
+ * the values the compiled code read from them, and its writes to them are
+ * dropped (see @ref Bus::set_device_replay).
+ *
+ * @throws CPUException If the results differ.
+ */
+InstructionErr Jit::execute_verified(CPU6502 &cpu, const DecodedBlock &block) {
+  Bus *bus = cpu.bus_;
+  std::byte *ram = bus->ram();
+
+  CPU6502 cpu_before = cpu;
+  Bus bus_before = *bus;
+  GP_Memory ram_before;
+  std::memcpy(ram_before.data(), ram, MEMORY_SIZE);
+
+  DeviceReplay devices;
+  bus->set_device_replay(&devices);
+
+  InstructionErr err = block.native(&cpu, ram, bus, &bus->code_version_);
+
+  CPU6502 compiled = cpu;
+  GP_Memory compiled_ram;
+  std::memcpy(compiled_ram.data(), ram, MEMORY_SIZE);
+
+  cpu = cpu_before;
+  *bus = bus_before;
+  std::memcpy(ram, ram_before.data(), MEMORY_SIZE);
+
+  devices.replaying = true;
+  bus->set_device_replay(&devices);
+
+  InstructionErr expected = cpu.run_block(block);
+  bus->set_device_replay(nullptr);
+
+  ++verified_runs_;
+
+  bool same = err == expected && compiled.A == cpu.A && compiled.X == cpu.X &&
+              compiled.Y == cpu.Y && compiled.S == cpu.S &&
+              compiled.P.get() == cpu.P.get() && compiled.PC == cpu.PC &&
+              compiled.get_cycles() == cpu.get_cycles() &&
+              std::memcmp(compiled_ram.data(), ram, MEMORY_SIZE) == 0;
+
+  if (!same) {
+    std::cerr << std::hex << "JIT: block run " << std::dec << verified_runs_
+              << " differs from the interpreter" << std::hex
+              << "\n  result  " << static_cast<int>(err) << " / "
+              << static_cast<int>(expected) << "\n  A       "
+              << static_cast<int>(compiled.A) << " / "
+              << static_cast<int>(cpu.A) << "\n  X       "
+              << static_cast<int>(compiled.X) << " / "
+              << static_cast<int>(cpu.X) << "\n  Y       "
+              << static_cast<int>(compiled.Y) << " / "
+              << static_cast<int>(cpu.Y) << "\n  S       "
+              << static_cast<int>(compiled.S) << " / "
+              << static_cast<int>(cpu.S) << "\n  P       "
+              << static_cast<int>(compiled.P.get()) << " / "
+              << static_cast<int>(cpu.P.get()) << "\n  PC      "
+              << compiled.PC.inner() << " / " << cpu.PC.inner() << std::dec
+              << "\n  cycles  " << compiled.get_cycles() << " / "
+              << cpu.get_cycles() << std::endl;
+
+    for (size_t i = 0; i < MEMORY_SIZE; ++i) {
+      if (compiled_ram.read(i) != ram[i]) {
+        std::cerr << "  [" << i << "] "
+                  << static_cast<int>(compiled_ram.read(i)) << " / "
+                  << static_cast<int>(ram[i]) << std::endl;
+      }
+    }
+
+    std::cerr << std::dec;
+
+    throw CPUException("The JIT and the interpreter disagree.");
+  }
+
+  return err;
+}
+
+void Jit::print_stats(std::ostream &stream) const {
+  stream << "JIT: " << compiled_blocks_ << " blocks compiled";
+
+  if (verify_) {
+    stream << ", " << verified_runs_ << " block runs verified";
+  }
+
+  stream << std::endl;
+}
+
+/**
+ * Runs the program like @ref run_cached, compiling blocks to host code once
+ * they were entered @ref JIT_HOT_THRESHOLD times. See @ref run.
+ *
+ * @throws CPUException If no cache or compiler was set.
+ */
+InstructionErr CPU6502::run_jit() {
+  if (block_cache_ == nullptr || jit_ == nullptr) {
+    throw CPUException("The JIT core needs a block cache and a JIT.");
+  }
+
+  while (true) {
+    if (!poll_events()) {
+      return InstructionErr::CycleLimit;
+    }
+
+    poll_interrupts();
+
+    DecodedBlock *block = block_cache_->lookup(PC);
+    InstructionErr err;
+
+    if (block == nullptr) {
+      err = step<Plain>();
+    } else if (block->idle_length != 0) [[unlikely]] {
+      err = run_idle_loop(*block);
+    } else {
+      if (block->native == nullptr &&
+          ++block->executions == JIT_HOT_THRESHOLD) {
+        jit_->compile(*block_cache_, *block, PC, *bus_);
+      }
+
+      err = block->native != nullptr ? jit_->execute(*this, *block)
+                                     : run_block(*block);
+    }
+
+    if (err != InstructionErr::OK && err != InstructionErr::OKPCModified) {
+      return err;
+    }
+  }
+}
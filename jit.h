@@ -0,0 +1,77 @@
+#ifndef _H_JIT
+#define _H_JIT
+
+#include "address.h"
+#include "block_cache.h"
+#include "bus.h"
+#include "instruction_types.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+class CPU6502;
+
+/**
+ * Blocks entered this many times by the interpreter are compiled.
+ */
+constexpr uint32_t JIT_HOT_THRESHOLD = 16;
+
+/**
+ * Size of the buffer for compiled code. When it fills up, all compiled code
+ * is dropped and hot blocks are compiled again.
+ */
+constexpr size_t JIT_CODE_SIZE = 16 * 1024 * 1024;
+
+/**
+ * Compiler of hot @ref DecodedBlock "decoded blocks" to x86-64 code.
+ *
+ * Loads, transfers, increments, logic, comparisons, flag changes, branches
+ * and jumps are translated to host instructions. Every other instruction is
+ * compiled to a direct call of its handler. Stores to ROM, devices or
+ * decoded code go through @ref Bus::write, so devices keep working and a
+ * store to decoded code leaves the block, exactly like in the interpreter.
+ *
+ * Only available on x86-64 Linux (see @ref supported); elsewhere nothing is
+ * compiled and all blocks are interpreted.
+ */
+class Jit {
+private:
+  class Compiler;
+
+  std::byte *code_ = nullptr;
+  size_t code_used_ = 0;
+
+  bool verify_ = false;
+
+  uint64_t compiled_blocks_ = 0;
+  uint64_t verified_runs_ = 0;
+
+  InstructionErr execute_verified(CPU6502 &cpu, const DecodedBlock &block);
+
+public:
+  Jit();
+  ~Jit();
+
+  Jit(const Jit &) = delete;
+  Jit &operator=(const Jit &) = delete;
+
+  static bool supported();
+
+  bool compile(BlockCache &cache, DecodedBlock &block, address start,
+               const Bus &bus);
+
+  InstructionErr execute(CPU6502 &cpu, const DecodedBlock &block);
+
+  /**
+   * In verify mode, every run of compiled code is repeated by the
+   * interpreter from the same state of the CPU and the RAM, and the results
+   * are compared.
+   */
+  void set_verify(bool value) { verify_ = value; };
+  bool is_verify() const { return verify_; };
+
+  void print_stats(std::ostream &stream) const;
+};
+
+#endif
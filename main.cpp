@@ -1,93 +1,426 @@
 #include "6502cpu.h"
+#include "async_writer.h"
+#include "binary_trace.h"
+#include "block_cache.h"
+#include "bus.h"
 #include "debugger.h"
+#include "fusion.h"
 #include "gp_memory.h"
+#include "input_device.h"
+#include "interrupt_controller.h"
+#include "jit.h"
+#include "mapped_image.h"
+#include "print_device.h"
+#include "scheduler.h"
+#include "throttle.h"
+#include "timer_device.h"
+#include <chrono>
 #include <cstring>
 #include <format>
 #include <iostream>
+#include <optional>
+#include <string_view>
+#include <unistd.h>
+#include <utility>
+#include <vector>
 
 constexpr const char *USAGE =
     "\n{} <path to binary file> [-d|--debug|-v|--verbose|--print-device "
-    "ADDR|--memory-size SIZE]\n"
+    "ADDR|--print-buffer POLICY|--print-async|--input FILE|--input-device "
+    "ADDR|--timer|--timer-device ADDR|--rom START-END|--core CORE|"
+    "--jit-verify|--fusion-stats|--clock HZ|--trace FILE|--trace-size N]\n"
     "  -d, --debug: enable debug mode\n"
     "  -v, --verbose: enable verbose mode\n"
     "  --print-device ADDR: set address of print device to ADDR, default "
-    "{:X}\n\n";
+    "{:X}\n"
+    "  --print-buffer POLICY: when to write out the output of the print "
+    "device,\n"
+    "    line (default), full[:SIZE], stop or end\n"
+    "  --print-async: write the output of the print device on a separate "
+    "thread\n"
+    "  --input FILE: feed FILE (- for standard input) to the input device\n"
+    "  --input-device ADDR: set address of input device to ADDR, default "
+    "{:X}\n"
+    "  --timer: map the interval timer\n"
+    "  --timer-device ADDR: set address of the timer to ADDR, default {:X}\n"
+    "  --rom START-END: map the pages from START to END of the image as ROM\n"
+    "  --core CORE: execution core, stepper (default), threaded, cached or "
+    "jit\n"
+    "  --jit-verify: check every run of compiled code against the "
+    "interpreter\n"
+    "  --fusion-stats: report how often each fused idiom ran on the cached "
+    "and\n    the JIT core\n"
+    "  --clock HZ: run at HZ cycles per second (k and M suffixes allowed)\n"
+    "  --trace FILE: record a binary trace to FILE, decode it with "
+    "trace_decode.out\n"
+    "  --trace-size N: keep the last N million records of the trace, default "
+    "1\n\n";
+
+/**
+ * Parse a ROM range given as `START-END` in hex. The range has to cover whole
+ * pages.
+ *
+ * @return The first page and the number of pages.
+ */
+static std::optional<std::pair<size_t, size_t>> parse_rom_range(char *range) {
+  char *end = nullptr;
+  unsigned long first = std::strtoul(range, &end, 16);
+
+  if (end == range || *end != '-') {
+    return std::nullopt;
+  }
+
+  char *last_str = end + 1;
+  unsigned long last = std::strtoul(last_str, &end, 16);
+
+  if (end == last_str || *end != '\0' || first > last ||
+      last >= MEMORY_SIZE || first % PAGE_SIZE != 0 ||
+      (last + 1) % PAGE_SIZE != 0) {
+    return std::nullopt;
+  }
+
+  return std::make_pair(first / PAGE_SIZE, (last + 1 - first) / PAGE_SIZE);
+}
 
 int main(int argc, char **argv) {
-  GP_Memory memory;
+  std::optional<MappedImage> image;
 
   if (argc <= 1) {
-    std::cout << std::format(USAGE, argv[0], DEFAULT_OUTPUT_ADDRESS);
+    std::cout << std::format(USAGE, argv[0], DEFAULT_OUTPUT_ADDRESS,
+                             DEFAULT_INPUT_ADDRESS, DEFAULT_TIMER_ADDRESS);
 
     return 1;
   }
 
-  // load the binary file into memory
+  // map the binary file, it is only copied where the program writes to it
+  auto load_start = std::chrono::steady_clock::now();
+
   try {
-    memory.import(argv[1]);
+    image.emplace(argv[1]);
   } catch (std::runtime_error &e) {
     std::cerr << e.what() << std::endl;
 
     return 1;
   }
 
-  CPU6502 cpu(&memory);
+  std::chrono::duration<double, std::micro> load_time =
+      std::chrono::steady_clock::now() - load_start;
 
-  for (int i = 0; i < argc; ++i) {
-    // skip program name
-    if (i == 0) {
-      continue;
-    }
+  Bus bus(image->data());
+  CPU6502 cpu(&bus);
+
+  address print_addr = address(DEFAULT_OUTPUT_ADDRESS);
+  FlushPolicy print_policy = FlushPolicy::Line;
+  size_t print_buffer_size = PRINT_BUFFER_SIZE;
+  bool print_async = false;
+  address input_addr = address(DEFAULT_INPUT_ADDRESS);
+  const char *input_file = nullptr;
+  bool timer = false;
+  bool fusion_stats = false;
+  const char *trace_file = nullptr;
+  uint64_t trace_records = DEFAULT_TRACE_RECORDS;
+  address timer_addr = address(DEFAULT_TIMER_ADDRESS);
+  std::vector<std::pair<size_t, size_t>> roms;
+  std::optional<Throttle> throttle;
+
+  BlockCache block_cache(&bus);
+  cpu.set_block_cache(&block_cache);
+
+  Jit jit;
+  cpu.set_jit(&jit);
+
+  InterruptController interrupts;
+  cpu.set_interrupts(&interrupts);
+
+  Scheduler scheduler(&cpu);
+  cpu.set_scheduler(&scheduler);
 
+  // skip program name and the binary file
+  for (int i = 2; i < argc; ++i) {
     char *arg = argv[i];
 
-    if (arg[0] == '-') {
-      // this is a flag
-
-      if (arg[1] == '-') {
-        // long flag
-        if (strcmp(arg, "--debug") == 0) {
-          // debug
-          cpu.set_debug(true);
-        } else if (strcmp(arg, "--verbose") == 0) {
-          // verbose
-          cpu.set_verbose(true);
-        } else if (strcmp(arg, "--print-device") == 0) {
-          // set print device address
-          char *addr_str = argv[++i];
-
-          try {
-            address print_addr = address(std::stoul(addr_str, nullptr, 16));
-
-            memory.set_print_device(print_addr);
-          } catch (std::invalid_argument &e) {
-            std::cerr << "Invalid address: " << addr_str << std::endl;
-
-            return 1;
-          }
-        } else {
-          // short flag
-          if (arg[1] == 'd') {
-            // debug
-            cpu.set_debug(true);
-          } else if (arg[1] == 'v') {
-            // verbose
-            cpu.set_verbose(true);
-          }
+    if (strcmp(arg, "-d") == 0 || strcmp(arg, "--debug") == 0) {
+      // debug
+      cpu.set_debug(true);
+    } else if (strcmp(arg, "-v") == 0 || strcmp(arg, "--verbose") == 0) {
+      // verbose
+      cpu.set_verbose(true);
+    } else if (strcmp(arg, "--print-device") == 0 && i + 1 < argc) {
+      // set print device address
+      char *addr_str = argv[++i];
+
+      try {
+        print_addr = address(std::stoul(addr_str, nullptr, 16));
+      } catch (std::invalid_argument &e) {
+        std::cerr << "Invalid address: " << addr_str << std::endl;
+
+        return 1;
+      }
+    } else if (strcmp(arg, "--print-buffer") == 0 && i + 1 < argc) {
+      // buffering of the print device, as POLICY or full:SIZE
+      std::string_view policy_str = argv[++i];
+      size_t colon = policy_str.find(':');
+      auto policy = parse_flush_policy(policy_str.substr(0, colon));
+
+      if (policy && colon != std::string_view::npos) {
+        char *end = nullptr;
+        const char *size_str = policy_str.data() + colon + 1;
+        print_buffer_size = std::strtoul(size_str, &end, 10);
+
+        if (*policy != FlushPolicy::Full || end == size_str || *end != '\0' ||
+            print_buffer_size == 0) {
+          policy = std::nullopt;
         }
       }
+
+      if (!policy) {
+        std::cerr << "Invalid print buffer policy: " << policy_str
+                  << std::endl;
+
+        return 1;
+      }
+
+      print_policy = *policy;
+    } else if (strcmp(arg, "--print-async") == 0) {
+      // write the output on a thread of its own
+      print_async = true;
+    } else if (strcmp(arg, "--input") == 0 && i + 1 < argc) {
+      // where the input device reads from
+      input_file = argv[++i];
+    } else if (strcmp(arg, "--input-device") == 0 && i + 1 < argc) {
+      // set input device address
+      char *addr_str = argv[++i];
+
+      try {
+        input_addr = address(std::stoul(addr_str, nullptr, 16));
+      } catch (std::invalid_argument &e) {
+        std::cerr << "Invalid address: " << addr_str << std::endl;
+
+        return 1;
+      }
+
+      // the status register follows the data register
+      if (input_addr.inner() == 0xFFFF) {
+        std::cerr << "Invalid address: " << addr_str << std::endl;
+
+        return 1;
+      }
+    } else if (strcmp(arg, "--timer") == 0) {
+      // map the interval timer
+      timer = true;
+    } else if (strcmp(arg, "--timer-device") == 0 && i + 1 < argc) {
+      // set timer address
+      char *addr_str = argv[++i];
+
+      try {
+        timer_addr = address(std::stoul(addr_str, nullptr, 16));
+      } catch (std::invalid_argument &e) {
+        std::cerr << "Invalid address: " << addr_str << std::endl;
+
+        return 1;
+      }
+
+      // the other registers follow the first one
+      if (timer_addr.inner() > MEMORY_SIZE - TIMER_REGISTERS) {
+        std::cerr << "Invalid address: " << addr_str << std::endl;
+
+        return 1;
+      }
+
+      timer = true;
+    } else if (strcmp(arg, "--rom") == 0 && i + 1 < argc) {
+      // map a part of the image as ROM
+      char *range_str = argv[++i];
+      auto range = parse_rom_range(range_str);
+
+      if (!range) {
+        std::cerr << "Invalid ROM range: " << range_str << std::endl;
+
+        return 1;
+      }
+
+      roms.push_back(*range);
+    } else if (strncmp(arg, "--core", 6) == 0) {
+      // select the execution core, as --core NAME or --core=NAME
+      const char *core_name = nullptr;
+
+      if (arg[6] == '=') {
+        core_name = arg + 7;
+      } else if (arg[6] == '\0' && i + 1 < argc) {
+        core_name = argv[++i];
+      }
+
+      auto core = parse_execution_core(core_name ? core_name : "");
+
+      if (!core) {
+        std::cerr << "Unknown core: " << (core_name ? core_name : "")
+                  << std::endl;
+
+        return 1;
+      }
+
+      cpu.set_core(*core);
+    } else if (strcmp(arg, "--jit-verify") == 0) {
+      // compare the compiled code with the interpreter
+      jit.set_verify(true);
+    } else if (strcmp(arg, "--fusion-stats") == 0) {
+      // count the runs of fused idioms
+      block_cache.set_count_fusions(true);
+      fusion_stats = true;
+    } else if (strcmp(arg, "--trace") == 0 && i + 1 < argc) {
+      // record a binary trace
+      trace_file = argv[++i];
+    } else if (strcmp(arg, "--trace-size") == 0 && i + 1 < argc) {
+      // millions of records the trace keeps
+      char *size_str = argv[++i];
+      char *end = nullptr;
+      uint64_t millions = std::strtoull(size_str, &end, 10);
+
+      if (end == size_str || *end != '\0' || millions == 0 ||
+          millions > UINT64_MAX / 1'000'000) {
+        std::cerr << "Invalid trace size: " << size_str << std::endl;
+
+        return 1;
+      }
+
+      trace_records = millions * 1'000'000;
+    } else if (strcmp(arg, "--clock") == 0 && i + 1 < argc) {
+      // run at a given clock speed
+      char *clock_str = argv[++i];
+      auto hz = parse_clock(clock_str);
+
+      if (!hz) {
+        std::cerr << "Invalid clock speed: " << clock_str << std::endl;
+
+        return 1;
+      }
+
+      throttle.emplace(*hz);
+      cpu.set_throttle(&*throttle);
+    } else {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      std::cout << std::format(USAGE, argv[0], DEFAULT_OUTPUT_ADDRESS,
+                             DEFAULT_INPUT_ADDRESS, DEFAULT_TIMER_ADDRESS);
+
+      return 1;
     }
+  }
+
+  for (const auto &[first_page, pages] : roms) {
+    bus.map_rom(first_page, pages, image->data() + first_page * PAGE_SIZE);
+  }
 
-    Debugger debugger(&cpu);
+  std::optional<InputDevice> input_device;
+
+  if (input_file != nullptr) {
+    if (strcmp(input_file, "-") == 0 && cpu.is_debug()) {
+      std::cerr << "The debugger cannot share the standard input with the "
+                   "input device."
+                << std::endl;
+
+      return 1;
+    }
 
     try {
-      debugger.run();
-    } catch (CPUException &e) {
-      std::cerr << e.message() << std::endl;
+      if (strcmp(input_file, "-") == 0) {
+        input_device.emplace(input_addr, STDIN_FILENO, &interrupts);
+      } else {
+        input_device.emplace(input_addr, std::string(input_file),
+                             &interrupts);
+      }
+    } catch (std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
 
       return 1;
     }
 
-    return 0;
+    bus.map_device(input_device->data_address(),
+                   input_device->status_address(), &*input_device);
+    input_device->set_bus(&bus);
   }
-}
\ No newline at end of file
+
+  std::optional<BinaryTrace> trace;
+
+  if (trace_file != nullptr) {
+    if (cpu.is_verbose()) {
+      std::cerr << "Verbose mode and --trace cannot be used together."
+                << std::endl;
+
+      return 1;
+    }
+
+    try {
+      trace.emplace(trace_file, trace_records);
+    } catch (std::runtime_error &e) {
+      std::cerr << e.what() << std::endl;
+
+      return 1;
+    }
+
+    cpu.set_hooks(&*trace);
+  }
+
+  std::optional<TimerDevice> timer_device;
+
+  if (timer) {
+    timer_device.emplace(timer_addr, &scheduler, &interrupts);
+    bus.map_device(timer_device->first_address(),
+                   timer_device->last_address(), &*timer_device);
+  }
+
+  // outlives the print device, which hands its output over to it
+  std::optional<AsyncWriter> print_writer;
+
+  PrintDevice print_device(std::cout, print_policy, print_buffer_size);
+  bus.map_device(print_addr, print_addr, &print_device);
+
+  if (print_async) {
+    std::cout.flush();
+
+    print_writer.emplace(STDOUT_FILENO);
+    print_device.set_writer(&*print_writer);
+  }
+
+  try {
+    // only debug mode goes through the debugger
+    if (cpu.is_debug()) {
+      Debugger debugger(&cpu);
+      debugger.run();
+    } else {
+      cpu.execute();
+    }
+  } catch (CPUException &e) {
+    std::cerr << e.message() << std::endl;
+
+    return 1;
+  }
+
+  if (print_writer) {
+    print_device.flush();
+    print_writer->drain();
+    print_writer->print_stats(std::cerr);
+  }
+
+  if (jit.is_verify()) {
+    jit.print_stats(std::cerr);
+  }
+
+  if (throttle) {
+    throttle->print_stats(std::cerr);
+  }
+
+  if (fusion_stats) {
+    print_fusion_stats(std::cerr);
+  }
+
+  if (cpu.skipped_idle_loops()) {
+    cpu.print_stats(std::cerr);
+  }
+
+  if (cpu.is_verbose()) {
+    std::cerr << "Loaded " << argv[1] << " in " << load_time.count() << " us"
+              << std::endl;
+  }
+
+  return 0;
+}
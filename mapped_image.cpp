@@ -0,0 +1,89 @@
+#include "mapped_image.h"
+#include "gp_memory.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MAPPED_IMAGE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static std::runtime_error open_error(const std::string &filename) {
+  return std::runtime_error(std::format(
+      "Could not open file {}. Make sure the assembled binary is there.",
+      filename));
+}
+
+MappedImage::MappedImage(const std::string &filename) {
+#ifdef MAPPED_IMAGE_MMAP
+  int fd = open(filename.c_str(), O_RDONLY);
+
+  if (fd < 0) {
+    throw open_error(filename);
+  }
+
+  struct stat status;
+
+  if (fstat(fd, &status) != 0) {
+    close(fd);
+
+    throw open_error(filename);
+  }
+
+  file_size_ = static_cast<size_t>(status.st_size);
+
+  // zeroed memory for the whole address space, with the file mapped over its
+  // beginning
+  void *base = mmap(nullptr, MEMORY_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+  if (base != MAP_FAILED && file_size_ > 0 &&
+      mmap(base, std::min(file_size_, MEMORY_SIZE), PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+    munmap(base, MEMORY_SIZE);
+    base = MAP_FAILED;
+  }
+
+  close(fd);
+
+  if (base == MAP_FAILED) {
+    throw std::runtime_error(std::format("Could not map file {}.", filename));
+  }
+
+  data_ = static_cast<std::byte *>(base);
+#else
+  std::ifstream file(filename, std::ios::binary);
+
+  if (!file.good()) {
+    throw open_error(filename);
+  }
+
+  data_ = new std::byte[MEMORY_SIZE]();
+
+  file.read(reinterpret_cast<char *>(data_), MEMORY_SIZE);
+  file.clear();
+  file.seekg(0, std::ios::end);
+  file_size_ = static_cast<size_t>(file.tellg());
+#endif
+
+  if (file_size_ > MEMORY_SIZE) {
+    std::cout << "Warning: The image is larger than the address space of the "
+                 "CPU, only the first 64 KiB are loaded."
+              << std::endl;
+  }
+}
+
+MappedImage::~MappedImage() {
+#ifdef MAPPED_IMAGE_MMAP
+  munmap(data_, MEMORY_SIZE);
+#else
+  delete[] data_;
+#endif
+}
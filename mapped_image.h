@@ -0,0 +1,44 @@
+#ifndef _H_MAPPED_IMAGE
+#define _H_MAPPED_IMAGE
+
+#include "gp_memory.h"
+
+#include <cstddef>
+#include <string>
+
+/**
+ * A binary image mapped into the host address space instead of being read.
+ *
+ * The image always spans the whole address space of the CPU, the part after
+ * the end of the file is zeroed. The mapping is private: pages that are only
+ * read stay shared with the file cache (a ROM mapped from the image is never
+ * copied), the first write to a page copies it.
+ *
+ * On hosts without `mmap` the file is read into memory instead.
+ */
+class MappedImage {
+private:
+  std::byte *data_ = nullptr;
+  size_t file_size_ = 0;
+
+public:
+  /**
+   * Map the image in the file @p filename.
+   *
+   * @throws std::runtime_error If the file could not be opened or mapped.
+   */
+  explicit MappedImage(const std::string &filename);
+  ~MappedImage();
+
+  MappedImage(const MappedImage &) = delete;
+  MappedImage &operator=(const MappedImage &) = delete;
+
+  /// The @ref MEMORY_SIZE bytes of the image.
+  std::byte *data() { return data_; }
+  const std::byte *data() const { return data_; }
+
+  /// Size of the file the image was mapped from.
+  size_t file_size() const { return file_size_; }
+};
+
+#endif
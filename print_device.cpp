@@ -0,0 +1,70 @@
+#include "print_device.h"
+#include "address.h"
+
+PrintDevice::PrintDevice(std::ostream &stream, FlushPolicy policy,
+                         size_t buffer_size)
+    : stream_(stream), policy_(policy),
+      buffer_size_(buffer_size > 0 ? buffer_size : 1) {
+  if (policy_ == FlushPolicy::Line || policy_ == FlushPolicy::Full) {
+    buffer_.reserve(buffer_size_);
+  }
+}
+
+PrintDevice::~PrintDevice() { flush(); }
+
+std::byte PrintDevice::read(address) { return last_; }
+
+void PrintDevice::write(address, std::byte value) {
+  char character = static_cast<char>(value);
+
+  buffer_.push_back(character);
+  last_ = value;
+
+  switch (policy_) {
+  case FlushPolicy::Line:
+    if (character == '\n' || buffer_.size() >= buffer_size_) {
+      flush();
+    }
+    break;
+  case FlushPolicy::Full:
+    if (buffer_.size() >= buffer_size_) {
+      flush();
+    }
+    break;
+  case FlushPolicy::Stop:
+  case FlushPolicy::End:
+  default:
+    break;
+  }
+}
+
+void PrintDevice::stopped() {
+  if (policy_ == FlushPolicy::End) {
+    return;
+  }
+
+  flush();
+
+  // the output has to be out before whatever the simulator prints next
+  if (writer_ != nullptr) {
+    writer_->drain();
+  }
+}
+
+void PrintDevice::flush() {
+  if (buffer_.empty()) {
+    return;
+  }
+
+  if (writer_ != nullptr) {
+    // the writer shares the file with the stream, which goes first
+    stream_.flush();
+    writer_->write(buffer_);
+  } else {
+    stream_.write(buffer_.data(),
+                  static_cast<std::streamsize>(buffer_.size()));
+    stream_.flush();
+  }
+
+  buffer_.clear();
+}
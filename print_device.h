@@ -0,0 +1,106 @@
+#ifndef _H_PRINT_DEVICE
+#define _H_PRINT_DEVICE
+
+#include "address.h"
+#include "async_writer.h"
+#include "device.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/**
+ * Default address of the memory mapped output print device.
+ */
+constexpr size_t DEFAULT_OUTPUT_ADDRESS = 0xFFFB;
+
+/**
+ * Default size of the output buffer of the print device.
+ */
+constexpr size_t PRINT_BUFFER_SIZE = 4096;
+
+/**
+ * When the print device writes its buffered output to the stream.
+ */
+enum class FlushPolicy : uint8_t {
+  /// After every newline, or when the buffer is full.
+  Line,
+  /// When the buffer is full.
+  Full,
+  /// Whenever the CPU stops running (STP, a breakpoint, an error).
+  Stop,
+  /// Only when the device is destroyed, at the end of the program.
+  End
+};
+
+/// Find the @ref FlushPolicy named @p name on the command line.
+inline std::optional<FlushPolicy> parse_flush_policy(std::string_view name) {
+  if (name == "line") {
+    return FlushPolicy::Line;
+  } else if (name == "full") {
+    return FlushPolicy::Full;
+  } else if (name == "stop") {
+    return FlushPolicy::Stop;
+  } else if (name == "end") {
+    return FlushPolicy::End;
+  }
+
+  return std::nullopt;
+}
+
+/**
+ * Output device that prints every byte written to it as an ASCII character.
+ * Reading it returns the last byte written.
+ *
+ * The output is collected in a buffer and written to the stream according to
+ * the @ref FlushPolicy, so programs printing a lot do not pay a stream call
+ * per character. Whatever is left in the buffer is written when the CPU stops
+ * (except with @ref FlushPolicy::End) and when the device is destroyed.
+ *
+ * With an @ref AsyncWriter (see @ref set_writer), the buffer is handed over to
+ * the writer thread instead of being written to the stream.
+ */
+class PrintDevice : public Device {
+private:
+  std::ostream &stream_;
+  FlushPolicy policy_;
+  size_t buffer_size_;
+
+  std::string buffer_;
+  std::byte last_{};
+
+  AsyncWriter *writer_ = nullptr;
+
+public:
+  /**
+   * @param stream The stream to print to.
+   * @param policy When to write the buffered output to the stream.
+   * @param buffer_size The size at which the buffer is written out with
+   * @ref FlushPolicy::Line and @ref FlushPolicy::Full.
+   */
+  explicit PrintDevice(std::ostream &stream,
+                       FlushPolicy policy = FlushPolicy::Line,
+                       size_t buffer_size = PRINT_BUFFER_SIZE);
+  ~PrintDevice() override;
+
+  PrintDevice(const PrintDevice &) = delete;
+  PrintDevice &operator=(const PrintDevice &) = delete;
+
+  std::byte read(address addr) override;
+  void write(address addr, std::byte value) override;
+  void stopped() override;
+
+  /**
+   * Hand the output to @p writer instead of the stream, or write it to the
+   * stream again if it is null. The writer has to outlive the device.
+   */
+  void set_writer(AsyncWriter *writer) { writer_ = writer; }
+
+  /// Write the buffered output to the stream, or hand it to the writer.
+  void flush();
+};
+
+#endif
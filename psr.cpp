@@ -1,54 +1,48 @@
 #include "psr.h"
 
 /**
- * Get the value of a bit in the PSR.
+ * Update the value of a bit in the PSR through a mapper.
  *
- * @param bit The bit to get.
- * @return bool Is the bit set?
+ * @param bit The bit to update.
+ * @param update The function to update the bit.
  */
-bool PSR::get_bit(psr_bit bit) const {
+void PSR::update_bit(psr_bit bit, std::function<bool(bool)> update) {
   if (bit == psr_bit::unused) {
-    return true;
+    return;
   }
 
-  return (psr_ & std::byte(1 << static_cast<size_t>(bit))) != std::byte(0);
+  bool current = get_bit(bit);
+  set_bit(bit, update(current));
 }
 
 /**
- * Set the value of a bit in the PSR.
- *
- * @param bit The bit to set.
- * @param value The value to set the bit to.
+ * Assemble the value of the register from the lazily kept flags.
  */
-void PSR::set_bit(psr_bit bit, bool value) {
-  if (bit == psr_bit::unused) {
-    return;
+std::byte PSR::get() const {
+  constexpr std::byte lazy = mask(psr_bit::negative) | mask(psr_bit::zero) |
+                             mask(psr_bit::overflow) | mask(psr_bit::carry);
+
+  std::byte value = psr_ & ~lazy;
+
+  if (get_bit(psr_bit::negative)) {
+    value |= mask(psr_bit::negative);
   }
 
-  if (value) {
-    psr_ |= std::byte(1 << static_cast<size_t>(bit));
-  } else {
-    psr_ &= std::byte(~(1 << static_cast<size_t>(bit)));
+  if (get_bit(psr_bit::zero)) {
+    value |= mask(psr_bit::zero);
   }
-}
 
-/**
- * Update the value of a bit in the PSR through a mapper.
- *
- * @param bit The bit to update.
- * @param update The function to update the bit.
- */
-void PSR::update_bit(psr_bit bit, std::function<bool(bool)> update) {
-  if (bit == psr_bit::unused) {
-    return;
+  if (get_bit(psr_bit::overflow)) {
+    value |= mask(psr_bit::overflow);
   }
 
-  bool current = get_bit(bit);
-  set_bit(bit, update(current));
-}
+  if (carry_) {
+    value |= mask(psr_bit::carry);
+  }
 
-std::byte PSR::get() const { return psr_; }
+  return value;
+}
 
 void PSR::set(std::byte value) {
-  psr_ = value | std::byte(1 << static_cast<size_t>(psr_bit::unused));
+  unpack(value | mask(psr_bit::unused));
 }
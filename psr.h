@@ -1,14 +1,15 @@
 #ifndef PSR_H
 #define PSR_H
 
+#include <cstddef>
 #include <functional>
 #include <stddef.h>
 
 /**
  * The initial value of the processor status register (P).
  *
- * On the real chip, no exact boot state is guaranteed. We set the (I) bit high
- * because we do not support hardware interrupts.
+ * On the real chip, no exact boot state is guaranteed, except that the reset
+ * sets the (I) bit, so IRQs stay masked until the program clears it.
  */
 constexpr unsigned char PSR_INITIAL_VALUE = 0b00100100;
 
@@ -30,21 +31,115 @@ enum class psr_bit {
 
 /**
  * Class that represents the processor status register (P) of the CPU.
+ *
+ * The N, Z, C and V flags are kept lazily: instead of the flag bits, the
+ * register stores what they were computed from (the last result, the carry
+ * and the overflow bit of the last addition) and only assembles the byte when
+ * it is read as a whole by @ref get. Setting N and Z from a result is then
+ * two plain stores instead of two read-modify-writes of the byte.
  */
 class PSR {
+  // the compiled code reads and writes the flags directly
+  friend class Jit;
+
 private:
+  /// The I, D, B and unused bits; the N, Z, C and V bits are not used.
   std::byte psr_;
+  /// N is bit 7 of this value.
+  std::byte negative_;
+  /// Z is set when this value is zero.
+  std::byte zero_;
+  /// V is bit 7 of this value.
+  std::byte overflow_;
+  bool carry_;
+
+  static constexpr std::byte mask(psr_bit bit) {
+    return std::byte(1 << static_cast<size_t>(bit));
+  }
+
+  void unpack(std::byte psr) {
+    psr_ = psr;
+    negative_ = psr & mask(psr_bit::negative);
+    zero_ = (psr & mask(psr_bit::zero)) == std::byte(0) ? std::byte(1)
+                                                        : std::byte(0);
+    overflow_ = (psr & mask(psr_bit::overflow)) << 1;
+    carry_ = (psr & mask(psr_bit::carry)) != std::byte(0);
+  }
 
 public:
-  PSR() : psr_(std::byte(PSR_INITIAL_VALUE)) {}
-  PSR(std::byte psr) : psr_(psr) {}
+  PSR() { unpack(std::byte(PSR_INITIAL_VALUE)); }
+  PSR(std::byte psr) { unpack(psr); }
+
+  /**
+   * Get the value of a bit in the PSR.
+   *
+   * @param bit The bit to get.
+   * @return bool Is the bit set?
+   */
+  bool get_bit(psr_bit bit) const {
+    switch (bit) {
+    case psr_bit::unused:
+      return true;
+    case psr_bit::negative:
+      return (negative_ & mask(psr_bit::negative)) != std::byte(0);
+    case psr_bit::zero:
+      return zero_ == std::byte(0);
+    case psr_bit::overflow:
+      return (overflow_ & std::byte(0x80)) != std::byte(0);
+    case psr_bit::carry:
+      return carry_;
+    default:
+      return (psr_ & mask(bit)) != std::byte(0);
+    }
+  }
+
+  /**
+   * Set the value of a bit in the PSR.
+   *
+   * @param bit The bit to set.
+   * @param value The value to set the bit to.
+   */
+  void set_bit(psr_bit bit, bool value) {
+    switch (bit) {
+    case psr_bit::unused:
+      return;
+    case psr_bit::negative:
+      negative_ = value ? std::byte(0x80) : std::byte(0);
+      return;
+    case psr_bit::zero:
+      zero_ = value ? std::byte(0) : std::byte(1);
+      return;
+    case psr_bit::overflow:
+      overflow_ = value ? std::byte(0x80) : std::byte(0);
+      return;
+    case psr_bit::carry:
+      carry_ = value;
+      return;
+    default:
+      if (value) {
+        psr_ |= mask(bit);
+      } else {
+        psr_ &= ~mask(bit);
+      }
+    }
+  }
+
+  /// Set N and Z as they would be for @p result.
+  void set_nz_from(std::byte result) { negative_ = zero_ = result; }
+
+  /// Set N to bit 7 of @p value.
+  void set_negative_from(std::byte value) { negative_ = value; }
+
+  /// Set Z if @p value is zero, clear it otherwise.
+  void set_zero_from(std::byte value) { zero_ = value; }
+
+  /// Set V to bit 7 of @p value.
+  void set_overflow_from(std::byte value) { overflow_ = value; }
 
-  bool get_bit(psr_bit bit) const;
-  void set_bit(psr_bit bit, bool value);
   void update_bit(psr_bit bit, std::function<bool(bool)> update);
 
   std::byte get() const;
   void set(std::byte value);
 };
 
-#endif
\ No newline at end of file
+#endif
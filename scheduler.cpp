@@ -0,0 +1,53 @@
+#include "scheduler.h"
+#include "6502cpu.h"
+
+Scheduler::Scheduler(CPU6502 *cpu) : cpu_(cpu) {
+  if (cpu_ == nullptr) {
+    throw CPUException("CPU cannot be null.");
+  }
+}
+
+uint64_t Scheduler::now() const { return cpu_->get_cycles(); }
+
+/**
+ * Let the CPU count down to the earliest event.
+ */
+void Scheduler::arm() {
+  cpu_->set_event_cycle(queue_.empty() ? now() + EVENT_HORIZON
+                                       : queue_.top().cycle);
+}
+
+Scheduler::EventId Scheduler::schedule(uint64_t cycle, Callback callback) {
+  EventId id = next_id_++;
+
+  queue_.push({cycle, id, std::move(callback)});
+  pending_.insert(id);
+
+  if (queue_.top().id == id) {
+    arm();
+  }
+
+  return id;
+}
+
+void Scheduler::cancel(EventId id) {
+  // dropped from the queue once it comes up
+  pending_.erase(id);
+}
+
+void Scheduler::run_due() {
+  while (!queue_.empty() && queue_.top().cycle <= now()) {
+    // the callback may schedule events itself
+    Event event = queue_.top();
+    queue_.pop();
+
+    if (pending_.erase(event.id) == 0) {
+      // cancelled
+      continue;
+    }
+
+    event.callback(event.cycle);
+  }
+
+  arm();
+}
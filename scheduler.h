@@ -0,0 +1,99 @@
+#ifndef _H_SCHEDULER
+#define _H_SCHEDULER
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+class CPU6502;
+
+/**
+ * How far ahead the CPU counts down while no event is scheduled.
+ */
+constexpr uint64_t EVENT_HORIZON = uint64_t(1) << 62;
+
+/**
+ * Runs device callbacks at given CPU cycles.
+ *
+ * The CPU counts down the cycles to the earliest scheduled event (see
+ * @ref CPU6502::set_event_cycle) and calls @ref run_due once it is reached,
+ * so until then running an instruction costs a subtraction and a branch, no
+ * matter how many events are scheduled. Events are taken between
+ * instructions or, on the block-based cores, between blocks, so a callback may
+ * run a few cycles late; it gets the cycle it was due at.
+ *
+ * Only the thread running the CPU may use the scheduler.
+ */
+class Scheduler {
+public:
+  /// Gets the cycle the event was due at.
+  using Callback = std::function<void(uint64_t)>;
+  using EventId = uint64_t;
+
+private:
+  struct Event {
+    uint64_t cycle;
+    EventId id;
+    Callback callback;
+
+    /// Later events, and later scheduled ones at the same cycle, come last.
+    bool operator>(const Event &other) const noexcept {
+      return cycle != other.cycle ? cycle > other.cycle : id > other.id;
+    }
+  };
+
+  CPU6502 *cpu_;
+
+  std::priority_queue<Event, std::vector<Event>, std::greater<>> queue_;
+  /**
+   * The events in the queue that have not been cancelled, so cancelling an
+   * event that already ran, or cancelling twice, leaves nothing behind.
+   */
+  std::unordered_set<EventId> pending_;
+  EventId next_id_ = 0;
+
+  void arm();
+
+public:
+  /**
+   * Create a scheduler for the cycles of @p cpu. The CPU has to be given the
+   * scheduler too (see @ref CPU6502::set_scheduler).
+   */
+  explicit Scheduler(CPU6502 *cpu);
+
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  /// The current cycle of the CPU.
+  uint64_t now() const;
+
+  /**
+   * Run @p callback at @p cycle, or before the next instruction if the cycle
+   * has passed.
+   *
+   * @return The event, to cancel it with @ref cancel.
+   */
+  EventId schedule(uint64_t cycle, Callback callback);
+
+  /// Run @p callback @p delay cycles from now, see @ref schedule.
+  EventId schedule_in(uint64_t delay, Callback callback) {
+    return schedule(now() + delay, std::move(callback));
+  }
+
+  /// Drop an event that has not run yet.
+  void cancel(EventId id);
+
+  /// Is any event scheduled?
+  bool has_events() const { return !queue_.empty(); }
+
+  /// The events that are still to run.
+  size_t pending_events() const { return pending_.size(); }
+
+  /// Run the callbacks of all events that are due, in order.
+  void run_due();
+};
+
+#endif
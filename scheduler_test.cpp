@@ -0,0 +1,166 @@
+#include "scheduler.h"
+#include "6502cpu.h"
+#include "unit_test.h"
+
+#include <cstdint>
+#include <format>
+#include <string>
+#include <vector>
+
+/// The cycles of a NOP, the most an event can run late.
+constexpr uint64_t NOP_CYCLES = 2;
+
+/// An event that ran.
+struct Run {
+  int tag;
+  /// The cycle it was due at, as given to the callback.
+  uint64_t due;
+  /// The cycle of the CPU when it ran.
+  uint64_t cycle;
+};
+
+/// A callback that adds a @ref Run tagged @p tag to @p runs.
+static Scheduler::Callback record(ScheduledMachine &machine,
+                                  std::vector<Run> &runs, int tag) {
+  return [&machine, &runs, tag](uint64_t due) {
+    runs.push_back({tag, due, machine.cpu.get_cycles()});
+  };
+}
+
+/// Check that @p runs are tagged @p tags in order and ran when they were due.
+static void check_runs(const std::vector<Run> &runs,
+                       const std::vector<int> &tags, const char *what) {
+  bool same = runs.size() == tags.size();
+
+  for (size_t i = 0; same && i < runs.size(); ++i) {
+    same = runs[i].tag == tags[i] && runs[i].cycle >= runs[i].due &&
+           runs[i].cycle < runs[i].due + NOP_CYCLES;
+  }
+
+  std::string got;
+
+  for (const Run &run : runs) {
+    got += std::format(" {}@{}/{}", run.tag, run.due, run.cycle);
+  }
+
+  check(same, std::format("{}: ran{}", what, got));
+}
+
+/**
+ * Events run in the order of their cycles, whatever order they were
+ * scheduled in, and events at the same cycle in the order they were
+ * scheduled.
+ */
+static void check_order(ExecutionCore core) {
+  ScheduledMachine machine(core);
+  std::vector<Run> runs;
+
+  machine.scheduler.schedule(100, record(machine, runs, 1));
+  machine.scheduler.schedule(40, record(machine, runs, 2));
+  machine.scheduler.schedule(70, record(machine, runs, 3));
+  machine.scheduler.schedule(40, record(machine, runs, 4));
+  machine.scheduler.schedule_in(41, record(machine, runs, 5));
+
+  machine.cpu.run_for_cycles(200);
+
+  check_runs(runs, {2, 4, 5, 3, 1}, "order");
+  check(!machine.scheduler.has_events(), "order: events left");
+}
+
+/**
+ * Cancelled events do not run, even the earliest one the CPU is counting
+ * down to; the events after it still run on time.
+ */
+static void check_cancel(ExecutionCore core) {
+  ScheduledMachine machine(core);
+  std::vector<Run> runs;
+
+  Scheduler::EventId first =
+      machine.scheduler.schedule(50, record(machine, runs, 1));
+  machine.scheduler.schedule(50, record(machine, runs, 2));
+  Scheduler::EventId last =
+      machine.scheduler.schedule(80, record(machine, runs, 3));
+  machine.scheduler.schedule(90, record(machine, runs, 4));
+
+  machine.scheduler.cancel(first);
+  machine.scheduler.cancel(last);
+  machine.scheduler.cancel(last);
+  // never scheduled
+  machine.scheduler.cancel(1000);
+
+  machine.cpu.run_for_cycles(100);
+
+  check_runs(runs, {2, 4}, "cancel");
+
+  // a new event is not taken for one of the cancelled ones
+  runs.clear();
+  machine.scheduler.schedule_in(10, record(machine, runs, 5));
+  machine.cpu.run_for_cycles(20);
+
+  check_runs(runs, {5}, "schedule after cancel");
+
+  // cancelling events that already ran keeps nothing
+  for (Scheduler::EventId id = 0; id < 6; ++id) {
+    machine.scheduler.cancel(id);
+  }
+
+  machine.scheduler.schedule_in(10, record(machine, runs, 6));
+  check(machine.scheduler.pending_events() == 1,
+        std::format("cancel: {} pending events after cancelling ran ones, "
+                    "expected 1",
+                    machine.scheduler.pending_events()));
+}
+
+/**
+ * Callbacks can schedule events: one due already runs before the next
+ * instruction, and an event scheduled again from its due cycle keeps its
+ * period however late each run was.
+ */
+static void check_reschedule(ExecutionCore core) {
+  ScheduledMachine machine(core);
+  std::vector<Run> runs;
+  Scheduler &scheduler = machine.scheduler;
+
+  int periods = 0;
+
+  Scheduler::Callback periodic = [&](uint64_t due) {
+    runs.push_back({1, due, machine.cpu.get_cycles()});
+
+    if (++periods < 5) {
+      scheduler.schedule(due + 33, periodic);
+    }
+  };
+
+  scheduler.schedule(33, periodic);
+  scheduler.schedule(40, [&](uint64_t due) {
+    runs.push_back({2, due, machine.cpu.get_cycles()});
+    scheduler.schedule(due, record(machine, runs, 3));
+  });
+
+  machine.cpu.run_for_cycles(400);
+
+  check_runs(runs, {1, 2, 3, 1, 1, 1, 1}, "reschedule");
+
+  bool periodic_on_time = true;
+  uint64_t expected = 33;
+
+  for (const Run &run : runs) {
+    if (run.tag == 1) {
+      periodic_on_time = periodic_on_time && run.due == expected;
+      expected += 33;
+    }
+  }
+
+  check(periodic_on_time, "reschedule: period drifted");
+}
+
+int main() {
+  for (ExecutionCore core :
+       {ExecutionCore::Stepper, ExecutionCore::Threaded}) {
+    check_order(core);
+    check_cancel(core);
+    check_reschedule(core);
+  }
+
+  return finish_checks("scheduler");
+}
@@ -0,0 +1,96 @@
+#ifndef _H_SPSC_RING
+#define _H_SPSC_RING
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <span>
+
+/**
+ * Lock-free ring buffer of bytes for exactly one producer thread and one
+ * consumer thread.
+ *
+ * The producer only writes @ref tail_, the consumer only writes @ref head_;
+ * both are free-running counters, so the fill level is their difference. The
+ * counters live on their own cache lines so the two threads do not keep
+ * stealing each other's line.
+ *
+ * @tparam Capacity The size of the buffer, a power of two.
+ */
+template <size_t Capacity> class SpscRing {
+  static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                "The capacity has to be a power of two.");
+
+private:
+  /// Bytes consumed so far, written by the consumer.
+  alignas(64) std::atomic<size_t> head_{0};
+  /// Bytes produced so far, written by the producer.
+  alignas(64) std::atomic<size_t> tail_{0};
+
+  alignas(64) std::array<char, Capacity> data_{};
+
+public:
+  static constexpr size_t capacity() { return Capacity; }
+
+  /// Number of bytes in the buffer. The other thread can change it right
+  /// away: the producer sees an upper bound, the consumer a lower bound.
+  size_t size() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Producer: copy as much of @p data as fits into the buffer.
+   *
+   * @return The number of bytes copied.
+   */
+  size_t push(std::span<const char> data) {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    size_t head = head_.load(std::memory_order_acquire);
+    size_t count = std::min(data.size(), Capacity - (tail - head));
+
+    size_t offset = tail % Capacity;
+    size_t first = std::min(count, Capacity - offset);
+
+    std::memcpy(data_.data() + offset, data.data(), first);
+    std::memcpy(data_.data(), data.data() + first, count - first);
+
+    tail_.store(tail + count, std::memory_order_release);
+
+    return count;
+  }
+
+  /**
+   * Consumer: the longest contiguous run of bytes that can be read, without
+   * removing them (see @ref consume).
+   */
+  std::span<const char> peek() const {
+    size_t head = head_.load(std::memory_order_relaxed);
+    size_t tail = tail_.load(std::memory_order_acquire);
+
+    size_t offset = head % Capacity;
+
+    return {data_.data() + offset, std::min(tail - head, Capacity - offset)};
+  }
+
+  /// Consumer: remove @p count bytes returned by @ref peek.
+  void consume(size_t count) {
+    size_t head = head_.load(std::memory_order_relaxed);
+
+    head_.store(head + count, std::memory_order_release);
+  }
+
+  /// Block until the consumer moves past @p head, see @ref head.
+  void wait_for_consumer(size_t head) const {
+    head_.wait(head, std::memory_order_acquire);
+  }
+
+  void notify_producer() { head_.notify_one(); }
+
+  /// Bytes consumed so far.
+  size_t head() const { return head_.load(std::memory_order_acquire); }
+};
+
+#endif
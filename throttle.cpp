@@ -0,0 +1,130 @@
+#include "throttle.h"
+#include "6502cpu.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <thread>
+
+std::optional<uint64_t> parse_clock(std::string_view clock) {
+  uint64_t multiplier = 1;
+
+  if (clock.ends_with('k')) {
+    multiplier = 1'000;
+    clock.remove_suffix(1);
+  } else if (clock.ends_with('M')) {
+    multiplier = 1'000'000;
+    clock.remove_suffix(1);
+  }
+
+  if (clock.empty() || clock.size() > 12) {
+    return std::nullopt;
+  }
+
+  uint64_t value = 0;
+
+  for (char digit : clock) {
+    if (digit < '0' || digit > '9') {
+      return std::nullopt;
+    }
+
+    value = value * 10 + static_cast<uint64_t>(digit - '0');
+  }
+
+  if (value == 0) {
+    return std::nullopt;
+  }
+
+  return value * multiplier;
+}
+
+Throttle::Throttle(uint64_t hz) : hz_(hz) {
+  if (hz_ == 0) {
+    throw CPUException("The clock speed cannot be zero.");
+  }
+
+  slice_cycles_ = std::max<uint64_t>(
+      1, hz_ * static_cast<uint64_t>(THROTTLE_SLICE.count()) / 1'000'000);
+}
+
+/**
+ * Sleep until shortly before @p deadline, then spin up to it.
+ */
+void Throttle::wait_until(Clock::time_point deadline) {
+  if (deadline - Clock::now() > THROTTLE_SPIN) {
+    std::this_thread::sleep_until(deadline - THROTTLE_SPIN);
+  }
+
+  while (Clock::now() < deadline) {
+  }
+}
+
+InstructionErr Throttle::run(CPU6502 &cpu) {
+  Clock::time_point start = Clock::now();
+  Clock::time_point run_start = start;
+  uint64_t start_cycle = cpu.get_cycles();
+
+  while (true) {
+    InstructionErr err = cpu.run_until(cpu.get_cycles() + slice_cycles_);
+
+    uint64_t cycles = cpu.get_cycles() - start_cycle;
+    // the host time the cycles so far take at the clock speed
+    auto deadline = start + std::chrono::duration_cast<Clock::duration>(
+                                std::chrono::duration<double>(
+                                    static_cast<double>(cycles) /
+                                    static_cast<double>(hz_)));
+    Clock::time_point now = Clock::now();
+
+    if (err != InstructionErr::CycleLimit) {
+      cycles_ += cpu.get_cycles() - start_cycle;
+      time_ += now - run_start;
+
+      return err;
+    }
+
+    ++slices_;
+
+    if (now < deadline) {
+      wait_until(deadline);
+      ++waits_;
+
+      Clock::duration late = Clock::now() - deadline;
+      double late_ns = static_cast<double>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(late).count());
+
+      late_sum_ += late_ns;
+      late_squares_ += late_ns * late_ns;
+      late_max_ = std::max(late_max_, late);
+    } else if (now - deadline > THROTTLE_MAX_LAG) {
+      // too far behind to catch up, the lost time is not made up
+      ++resyncs_;
+
+      cycles_ += cpu.get_cycles() - start_cycle;
+      time_ += now - run_start;
+      start = run_start = now;
+      start_cycle = cpu.get_cycles();
+    }
+  }
+}
+
+void Throttle::print_stats(std::ostream &stream) const {
+  double seconds = std::chrono::duration<double>(time_).count();
+  double mhz = seconds > 0 ? static_cast<double>(cycles_) / seconds / 1e6 : 0;
+
+  double waits = static_cast<double>(waits_);
+  double mean = waits_ > 0 ? late_sum_ / waits : 0;
+  double deviation =
+      waits_ > 0 ? std::sqrt(std::max(0.0, late_squares_ / waits - mean * mean))
+                 : 0;
+
+  stream << std::fixed << std::setprecision(3) << "Clock: "
+         << static_cast<double>(hz_) / 1e6 << " MHz set, " << mhz
+         << " MHz achieved over " << cycles_ << " cycles, " << slices_
+         << " slices (" << waits_ << " waited), wake-up jitter "
+         << std::setprecision(1) << mean / 1e3 << " us mean, "
+         << deviation / 1e3 << " us deviation, "
+         << std::chrono::duration<double, std::micro>(late_max_).count()
+         << " us max, " << resyncs_ << " resyncs" << std::endl;
+
+  stream << std::defaultfloat;
+}
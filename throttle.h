@@ -0,0 +1,85 @@
+#ifndef _H_THROTTLE
+#define _H_THROTTLE
+
+#include "instruction_types.h"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string_view>
+
+class CPU6502;
+
+/// Length of one time slice of a throttled run, in host time.
+constexpr std::chrono::microseconds THROTTLE_SLICE{1000};
+
+/**
+ * How long before the end of a slice the throttle stops sleeping and spins
+ * instead, sleeping to the deadline would overshoot by the wake-up latency.
+ */
+constexpr std::chrono::microseconds THROTTLE_SPIN{50};
+
+/**
+ * How far the CPU may fall behind the clock before the throttle gives up on
+ * catching up and starts counting from the current time again.
+ */
+constexpr std::chrono::milliseconds THROTTLE_MAX_LAG{50};
+
+/**
+ * Parse a clock speed given in Hz, optionally with a `k` or `M` suffix
+ * (`1M`, `8M`, `14318k`).
+ */
+std::optional<uint64_t> parse_clock(std::string_view clock);
+
+/**
+ * Runs a CPU at a given clock speed instead of as fast as it can.
+ *
+ * The CPU runs in slices of @ref THROTTLE_SLICE worth of cycles (see
+ * @ref CPU6502::run_until). After each slice, the throttle sleeps until the
+ * host time the slice should have ended at, measured from the start of the
+ * run rather than from the previous slice, so a slice that ends late is made
+ * up by the following ones. If the CPU falls more than
+ * @ref THROTTLE_MAX_LAG behind (the host is too slow, or the program sat in
+ * the debugger), the throttle starts counting again from the current time.
+ *
+ * How late the throttle wakes up after each slice is kept for
+ * @ref print_stats, along with the speed the CPU ran at.
+ */
+class Throttle {
+public:
+  using Clock = std::chrono::steady_clock;
+
+private:
+  uint64_t hz_;
+  uint64_t slice_cycles_;
+
+  // statistics over all runs
+  uint64_t cycles_ = 0;
+  Clock::duration time_{};
+  uint64_t slices_ = 0;
+  /// Slices that ended early and waited for the clock.
+  uint64_t waits_ = 0;
+  uint64_t resyncs_ = 0;
+  /// Sum and sum of squares of the wake-up lateness, in nanoseconds.
+  double late_sum_ = 0, late_squares_ = 0;
+  Clock::duration late_max_{};
+
+  void wait_until(Clock::time_point deadline);
+
+public:
+  /// @throws CPUException If @p hz is zero.
+  explicit Throttle(uint64_t hz);
+
+  uint64_t hz() const { return hz_; }
+
+  /**
+   * Run the program on @p cpu at the clock speed until an instruction stops
+   * it. See @ref CPU6502::run.
+   */
+  InstructionErr run(CPU6502 &cpu);
+
+  void print_stats(std::ostream &stream) const;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "timer_device.h"
+#include "6502cpu.h"
+
+/// Offsets of the registers from the first address.
+enum TimerRegister : uint16_t {
+  COUNTER_LOW = 0,
+  COUNTER_HIGH = 1,
+  CONTROL = 2,
+  STATUS = 3
+};
+
+TimerDevice::TimerDevice(address base, Scheduler *scheduler,
+                         InterruptController *interrupts)
+    : base_(base), scheduler_(scheduler), interrupts_(interrupts) {
+  if (scheduler_ == nullptr) {
+    throw CPUException("Scheduler cannot be null.");
+  }
+
+  if (interrupts_ != nullptr) {
+    irq_source_ = interrupts_->add_source();
+  }
+}
+
+TimerDevice::~TimerDevice() {
+  if (armed_) {
+    scheduler_->cancel(event_);
+  }
+}
+
+/**
+ * The value of the counter, from the cycles passed since it was loaded.
+ */
+uint16_t TimerDevice::counter() const {
+  uint64_t elapsed = scheduler_->now() - start_cycle_;
+
+  // an underflow that is due may not have run yet on the block-based cores
+  if (free_running() && armed_) {
+    elapsed %= uint64_t(latch_) + 1;
+  }
+
+  return static_cast<uint16_t>(latch_ - elapsed);
+}
+
+/**
+ * Load the counter from the latch and schedule its underflow.
+ */
+void TimerDevice::start() {
+  if (armed_) {
+    scheduler_->cancel(event_);
+  }
+
+  start_cycle_ = scheduler_->now();
+  underflow_ = false;
+  update_irq();
+
+  schedule_underflow(start_cycle_ + latch_ + 1);
+}
+
+void TimerDevice::schedule_underflow(uint64_t cycle) {
+  armed_ = true;
+  event_ = scheduler_->schedule(cycle, [this](uint64_t due) { expire(due); });
+}
+
+/**
+ * The counter went past zero at @p cycle: set the flag and, in free-running
+ * mode, reload the counter.
+ */
+void TimerDevice::expire(uint64_t cycle) {
+  armed_ = false;
+  underflow_ = true;
+  update_irq();
+
+  if (free_running()) {
+    start_cycle_ = cycle;
+    schedule_underflow(cycle + latch_ + 1);
+  }
+}
+
+void TimerDevice::update_irq() {
+  if (interrupts_ != nullptr) {
+    interrupts_->set_irq(irq_source_,
+                         underflow_ &&
+                             (control_ & TIMER_IRQ_ENABLE) != std::byte{0});
+  }
+}
+
+std::byte TimerDevice::read(address addr) {
+  switch (static_cast<uint16_t>(addr.inner() - base_.inner())) {
+  case COUNTER_LOW:
+    return std::byte(counter() & 0xFF);
+  case COUNTER_HIGH:
+    return std::byte(counter() >> 8);
+  case CONTROL:
+    return control_;
+  case STATUS:
+  default:
+    return underflow_ ? TIMER_UNDERFLOW : std::byte{0};
+  }
+}
+
+void TimerDevice::write(address addr, std::byte value) {
+  switch (static_cast<uint16_t>(addr.inner() - base_.inner())) {
+  case COUNTER_LOW:
+    latch_ = static_cast<uint16_t>((latch_ & 0xFF00) |
+                                   std::to_integer<uint16_t>(value));
+    break;
+  case COUNTER_HIGH:
+    latch_ = static_cast<uint16_t>((latch_ & 0x00FF) |
+                                   std::to_integer<uint16_t>(value) << 8);
+    start();
+    break;
+  case CONTROL:
+    control_ = value & (TIMER_FREE_RUN | TIMER_IRQ_ENABLE);
+    update_irq();
+    break;
+  case STATUS:
+  default:
+    underflow_ = false;
+    update_irq();
+    break;
+  }
+}
@@ -0,0 +1,105 @@
+#ifndef _H_TIMER_DEVICE
+#define _H_TIMER_DEVICE
+
+#include "address.h"
+#include "device.h"
+#include "interrupt_controller.h"
+#include "scheduler.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Default address of the first register of the timer device, the other three
+ * follow it.
+ */
+constexpr uint16_t DEFAULT_TIMER_ADDRESS = 0xFFE0;
+
+/// Number of registers of the timer device.
+constexpr uint16_t TIMER_REGISTERS = 4;
+
+/// Control bit: reload the counter from the latch on every underflow.
+constexpr std::byte TIMER_FREE_RUN{0x40};
+/// Control bit: assert IRQ while the underflow flag is set.
+constexpr std::byte TIMER_IRQ_ENABLE{0x80};
+/// Status bit: the counter has underflowed since the flag was cleared.
+constexpr std::byte TIMER_UNDERFLOW{0x80};
+
+/**
+ * A programmable interval timer, modelled after timer 1 of the 6522 VIA.
+ *
+ * The counter counts down by one every CPU cycle. It has four registers:
+ *
+ * - counter low (the first address): reading returns the low byte of the
+ *   counter, writing sets the low byte of the latch,
+ * - counter high: reading returns the high byte of the counter, writing sets
+ *   the high byte of the latch, loads the counter from the latch, clears the
+ *   underflow flag and starts counting,
+ * - control: @ref TIMER_FREE_RUN and @ref TIMER_IRQ_ENABLE,
+ * - status: @ref TIMER_UNDERFLOW is set once the counter goes past zero,
+ *   writing any value clears it.
+ *
+ * In one-shot mode the counter underflows once, then goes on counting down
+ * from `FFFF` without setting the flag again. In free-running mode it is
+ * reloaded from the latch, so the flag is set every `latch + 1` cycles.
+ *
+ * The counter is never decremented. The device remembers the cycle it was
+ * loaded at and computes its value from the cycles of the CPU when it is
+ * read; the underflow is an event on the @ref Scheduler. Only the thread
+ * running the CPU may use the device.
+ */
+class TimerDevice : public Device {
+private:
+  address base_;
+
+  Scheduler *scheduler_;
+  InterruptController *interrupts_ = nullptr;
+  unsigned irq_source_ = 0;
+
+  uint16_t latch_ = 0;
+  std::byte control_{};
+  bool underflow_ = false;
+
+  /// The cycle the counter was loaded from the latch at.
+  uint64_t start_cycle_ = 0;
+  /// The pending underflow, if any.
+  bool armed_ = false;
+  Scheduler::EventId event_ = 0;
+
+  uint16_t counter() const;
+  void start();
+  void schedule_underflow(uint64_t cycle);
+  void expire(uint64_t cycle);
+  void update_irq();
+
+  bool free_running() const {
+    return (control_ & TIMER_FREE_RUN) != std::byte{0};
+  }
+
+public:
+  /**
+   * @param base The address of the first register.
+   * @param scheduler The clock of the device. Has to outlive the device.
+   * @param interrupts The IRQ line of the device, if any. Has to outlive the
+   * device.
+   * @throws CPUException If the scheduler is null.
+   * @throws std::runtime_error If the controller has no IRQ source left.
+   */
+  TimerDevice(address base, Scheduler *scheduler,
+              InterruptController *interrupts = nullptr);
+  ~TimerDevice() override;
+
+  TimerDevice(const TimerDevice &) = delete;
+  TimerDevice &operator=(const TimerDevice &) = delete;
+
+  /// The address of the first register, see @ref last_address.
+  address first_address() const { return base_; }
+  address last_address() const {
+    return address(static_cast<uint16_t>(base_.inner() + TIMER_REGISTERS - 1));
+  }
+
+  std::byte read(address addr) override;
+  void write(address addr, std::byte value) override;
+};
+
+#endif
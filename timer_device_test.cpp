@@ -0,0 +1,142 @@
+#include "timer_device.h"
+#include "6502cpu.h"
+#include "address.h"
+#include "interrupt_controller.h"
+#include "psr.h"
+#include "unit_test.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+
+constexpr uint16_t TIMER = DEFAULT_TIMER_ADDRESS;
+
+/// A CPU running NOPs with the timer mapped at its default address.
+struct TimerMachine : ScheduledMachine {
+  InterruptController interrupts;
+  TimerDevice timer;
+
+  TimerMachine() : timer(address(TIMER), &scheduler, &interrupts) {
+    cpu.set_interrupts(&interrupts);
+    bus.map_device(timer.first_address(), timer.last_address(), &timer);
+  }
+
+  /// Set the control register, then load the counter with @p latch.
+  void start(uint16_t latch, std::byte control) {
+    bus.write(address(TIMER + 2), control);
+    bus.write(address(TIMER), std::byte(latch & 0xFF));
+    bus.write(address(TIMER + 1), std::byte(latch >> 8));
+  }
+
+  /// Run the CPU until cycle @p cycle, NOPs stop exactly on even cycles.
+  void run_until(uint64_t cycle) {
+    cpu.run_for_cycles(cycle - cpu.get_cycles());
+  }
+
+  uint16_t counter() {
+    return static_cast<uint16_t>(
+        std::to_integer<uint16_t>(bus.read(address(TIMER))) |
+        std::to_integer<uint16_t>(bus.read(address(TIMER + 1))) << 8);
+  }
+
+  bool underflow() {
+    return bus.read(address(TIMER + 3)) == TIMER_UNDERFLOW;
+  }
+
+  void clear_underflow() { bus.write(address(TIMER + 3), std::byte{0}); }
+};
+
+/**
+ * A one-shot timer loaded with N underflows N + 1 cycles later, once, and
+ * then goes on counting down from FFFF.
+ */
+static void check_one_shot() {
+  TimerMachine machine;
+  machine.start(100, std::byte{0});
+
+  machine.run_until(50);
+  check(machine.counter() == 50,
+        std::format("one-shot: counter {} at cycle 50, expected 50",
+                    machine.counter()));
+
+  machine.run_until(100);
+  check(!machine.underflow(), "one-shot: underflow at cycle 100");
+
+  machine.run_until(102);
+  check(machine.underflow(), "one-shot: no underflow at cycle 102");
+  check(machine.counter() == 0xFFFE,
+        std::format("one-shot: counter {} at cycle 102, expected 65534",
+                    machine.counter()));
+
+  machine.clear_underflow();
+  machine.run_until(1000);
+  check(!machine.underflow(), "one-shot: underflow again");
+}
+
+/**
+ * A free-running timer loaded with N underflows every N + 1 cycles, and its
+ * counter starts again from N each time.
+ */
+static void check_free_running() {
+  TimerMachine machine;
+  machine.start(99, TIMER_FREE_RUN);
+
+  for (uint64_t period = 100; period <= 1000; period += 100) {
+    machine.run_until(period - 2);
+
+    if (!check(!machine.underflow(),
+               std::format("free-running: underflow at cycle {}",
+                           period - 2))) {
+      return;
+    }
+
+    machine.run_until(period);
+
+    if (!check(machine.underflow(),
+               std::format("free-running: no underflow at cycle {}",
+                           period))) {
+      return;
+    }
+
+    machine.clear_underflow();
+  }
+
+  // half way through a period
+  machine.run_until(1050);
+  check(machine.counter() == 49,
+        std::format("free-running: counter {} at cycle 1050, expected 49",
+                    machine.counter()));
+}
+
+/**
+ * With IRQ enabled, the underflow asserts IRQ until the flag is cleared, and
+ * the CPU takes it.
+ */
+static void check_irq() {
+  TimerMachine machine;
+  machine.load(IRQ_VECTOR, {0x00, 0x30});
+  machine.cpu.set_PSR(PSR(std::byte{0x00}));
+  machine.start(50, TIMER_IRQ_ENABLE);
+
+  machine.run_until(50);
+  check(machine.cpu.get_PC().inner() < 0x3000, "IRQ: taken before cycle 51");
+
+  machine.run_until(70);
+  check(machine.cpu.get_PC().inner() >= 0x3000 &&
+            machine.cpu.get_PSR()->get_bit(psr_bit::interrupt_disable),
+        "IRQ: not taken after the underflow");
+  check((machine.interrupts.pending().load() & IRQ_PENDING) != 0,
+        "IRQ: released before the flag was cleared");
+
+  machine.clear_underflow();
+  check((machine.interrupts.pending().load() & IRQ_PENDING) == 0,
+        "IRQ: still asserted after the flag was cleared");
+}
+
+int main() {
+  check_one_shot();
+  check_free_running();
+  check_irq();
+
+  return finish_checks("timer_device");
+}
@@ -0,0 +1,49 @@
+#include "../binary_trace.h"
+
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Prints a trace recorded with `--trace` in the format of verbose mode.
+ */
+int main(int argc, char **argv) {
+  bool effects = false;
+  const char *file = nullptr;
+
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "-e") == 0 || strcmp(argv[i], "--effects") == 0) {
+      effects = true;
+    } else if (file == nullptr) {
+      file = argv[i];
+    } else {
+      file = nullptr;
+      break;
+    }
+  }
+
+  if (file == nullptr) {
+    std::cout << "Usage: " << argv[0] << " [-e|--effects] <path to trace>\n"
+              << "  -e, --effects: also print the registers before every "
+                 "instruction and the\n    reads and writes\n";
+
+    return 1;
+  }
+
+  try {
+    uint64_t overwritten = decode_trace(file, std::cout, effects);
+
+    if (overwritten != 0) {
+      std::cerr << overwritten << " older records were overwritten."
+                << std::endl;
+    }
+  } catch (std::runtime_error &e) {
+    std::cerr << e.what() << std::endl;
+
+    return 1;
+  }
+
+  return 0;
+}
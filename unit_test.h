@@ -0,0 +1,136 @@
+#ifndef _H_UNIT_TEST
+#define _H_UNIT_TEST
+
+#include "6502cpu.h"
+#include "address.h"
+#include "block_cache.h"
+#include "bus.h"
+#include "gp_memory.h"
+#include "jit.h"
+#include "scheduler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <initializer_list>
+#include <iostream>
+#include <string_view>
+
+/**
+ * Support for the checks in the `*_test.cpp` programs next to the code they
+ * check, which `make test` builds and runs.
+ *
+ * A program makes its checks with @ref check and returns
+ * @ref finish_checks from `main`, so a failed check is reported but does not
+ * stop the checks after it. Code under test runs on a @ref TestMachine.
+ */
+
+/// The checks that failed so far.
+inline int failed_checks = 0;
+
+/**
+ * Report @p what as failed unless @p condition holds.
+ *
+ * @return The condition, so loops over many cases can stop at the first
+ * failure.
+ */
+inline bool check(bool condition, std::string_view what) {
+  if (!condition) {
+    std::cerr << "FAILED: " << what << std::endl;
+    ++failed_checks;
+  }
+
+  return condition;
+}
+
+/**
+ * Report the result of the checks of @p name.
+ *
+ * @return The exit status of the program.
+ */
+inline int finish_checks(std::string_view name) {
+  if (failed_checks != 0) {
+    std::cerr << name << ": " << failed_checks << " checks failed"
+              << std::endl;
+
+    return EXIT_FAILURE;
+  }
+
+  std::cout << name << ": all checks passed" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+/// Where a @ref TestMachine starts running after reset.
+constexpr uint16_t TEST_CODE = 0x0200;
+
+/// The opcode of NOP, the code a @ref ScheduledMachine runs.
+constexpr uint8_t NOP = 0xEA;
+
+/**
+ * A CPU on a bus with the whole address space of memory, zeroed but for the
+ * reset vector, which points at @ref TEST_CODE.
+ */
+struct TestMachine {
+  GP_Memory memory;
+  Bus bus;
+  CPU6502 cpu;
+
+  TestMachine() : bus(with_reset_vector(memory)), cpu(&bus) {}
+
+  // the CPU and the bus point at the memory of this machine
+  TestMachine(const TestMachine &) = delete;
+  TestMachine &operator=(const TestMachine &) = delete;
+
+  /// Put @p bytes into the memory from @p start on.
+  void load(uint16_t start, std::initializer_list<uint8_t> bytes) {
+    for (uint8_t byte : bytes) {
+      bus.write(address(start++), std::byte(byte));
+    }
+  }
+
+  /// Fill the memory with @p byte, but for the reset vector.
+  void fill(uint8_t byte) {
+    std::fill(memory.data(), memory.data() + RESET_VECTOR_LOW, std::byte(byte));
+    std::fill(memory.data() + RESET_VECTOR_HIGH + 1,
+              memory.data() + MEMORY_SIZE, std::byte(byte));
+  }
+
+private:
+  static GP_Memory *with_reset_vector(GP_Memory &memory) {
+    memory.write(address(RESET_VECTOR_LOW), std::byte(TEST_CODE & 0xFF));
+    memory.write(address(RESET_VECTOR_HIGH), std::byte(TEST_CODE >> 8));
+
+    return &memory;
+  }
+};
+
+/// A @ref TestMachine that runs on @p core.
+struct CoreMachine : TestMachine {
+  BlockCache block_cache;
+  Jit jit;
+
+  explicit CoreMachine(ExecutionCore core) : block_cache(&bus) {
+    cpu.set_block_cache(&block_cache);
+    cpu.set_jit(&jit);
+    cpu.set_core(core);
+  }
+};
+
+/**
+ * A @ref TestMachine running NOPs forever on @p core, with a scheduler, for
+ * devices and events that count cycles.
+ */
+struct ScheduledMachine : TestMachine {
+  Scheduler scheduler;
+
+  explicit ScheduledMachine(ExecutionCore core = ExecutionCore::Stepper)
+      : scheduler(&cpu) {
+    fill(NOP);
+    cpu.set_core(core);
+    cpu.set_scheduler(&scheduler);
+  }
+};
+
+#endif